@@ -0,0 +1,95 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace
+{
+
+std::atomic<std::size_t> allocations(0);
+std::atomic<std::size_t> frees(0);
+std::atomic<std::size_t> bytesAllocated(0);
+std::atomic<std::size_t> bytesFreed(0);
+
+// Size of a block freed through an unsized delete, i.e. from code built
+// without sized deallocation. malloc's rounded size is the best guess left.
+std::size_t blockSize(void * memory)
+{
+#ifdef __GLIBC__
+    return malloc_usable_size(memory);
+#else
+    (void)memory;
+    return 0;
+#endif
+}
+
+void * allocate(std::size_t size)
+{
+    if (size == 0)
+        size = 1;
+    for (;;)
+    {
+        if (void * memory = std::malloc(size))
+        {
+            allocations.fetch_add(1, std::memory_order_relaxed);
+            bytesAllocated.fetch_add(size, std::memory_order_relaxed);
+            return memory;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+void deallocate(void * memory, std::size_t size)
+{
+    if (!memory)
+        return;
+    frees.fetch_add(1, std::memory_order_relaxed);
+    bytesFreed.fetch_add(size ? size : 1, std::memory_order_relaxed);
+    std::free(memory);
+}
+
+}
+
+aisdi::benchmark::AllocationStats aisdi::benchmark::allocationStats()
+{
+    return { allocations.load(std::memory_order_relaxed), frees.load(std::memory_order_relaxed),
+             bytesAllocated.load(std::memory_order_relaxed), bytesFreed.load(std::memory_order_relaxed) };
+}
+
+void * operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void * operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+void operator delete(void * memory) noexcept
+{
+    deallocate(memory, memory ? blockSize(memory) : 0);
+}
+
+void operator delete[](void * memory) noexcept
+{
+    deallocate(memory, memory ? blockSize(memory) : 0);
+}
+
+void operator delete(void * memory, std::size_t size) noexcept
+{
+    deallocate(memory, size);
+}
+
+void operator delete[](void * memory, std::size_t size) noexcept
+{
+    deallocate(memory, size);
+}
@@ -0,0 +1,48 @@
+#ifndef AISDI_MAPS_ALLOCATIONCOUNTER_H
+#define AISDI_MAPS_ALLOCATIONCOUNTER_H
+
+#include <cstddef>
+
+namespace aisdi
+{
+namespace benchmark
+{
+
+// Heap traffic through the global operator new/delete since the start of
+// the program. Bytes are the requested sizes, so they do not depend on
+// malloc's rounding or on how fragmented the heap is. Frees learn the size
+// from sized deallocation, which the benchmark target is built with; a
+// block freed by an unsized delete counts with malloc_usable_size (0
+// outside glibc).
+struct AllocationStats
+{
+  std::size_t allocations;
+  std::size_t frees;
+  std::size_t bytesAllocated;
+  std::size_t bytesFreed;
+
+  std::size_t liveAllocations() const
+  {
+    return allocations - frees;
+  }
+
+  std::size_t liveBytes() const
+  {
+    return bytesAllocated - bytesFreed;
+  }
+
+  AllocationStats operator-(const AllocationStats& other) const
+  {
+    return { allocations - other.allocations, frees - other.frees,
+             bytesAllocated - other.bytesAllocated, bytesFreed - other.bytesFreed };
+  }
+};
+
+// Counting is done by the replacement operators in AllocationCounter.cpp,
+// so it only works in programs linked with that file (the benchmark driver).
+AllocationStats allocationStats();
+
+}
+}
+
+#endif /* AISDI_MAPS_ALLOCATIONCOUNTER_H */
@@ -0,0 +1,496 @@
+#ifndef AISDI_MAPS_BENCHMARK_H
+#define AISDI_MAPS_BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <AllocationCounter.h>
+#include <InstrumentedKey.h>
+#include <PerfCounters.h>
+#include <Workloads.h>
+
+namespace aisdi
+{
+namespace benchmark
+{
+
+using Clock = std::chrono::steady_clock;
+
+// Timings of one scenario. Operations are timed in batches (a single
+// steady_clock read costs about as much as a hash lookup), and every batch
+// gives one ns/op sample; every percentile and the max are taken exactly
+// over those samples, so the columns never decrease. They are
+// percentiles of batch averages, which hide the slow operations of a
+// batch; only with a batch of 1 are they per-operation latencies.
+class Samples
+{
+private:
+  std::vector<double> nsPerOp;
+  double totalNs;
+  std::size_t totalOps;
+  std::size_t batchOps;
+  AllocationStats heap;
+  PerfCounters::Reading events;
+  bool counted[PerfCounters::EVENTS];
+  KeyCounters keys;
+
+public:
+  Samples() : totalNs(0), totalOps(0), batchOps(0), heap(), keys()
+  {
+    for (std::size_t i = 0; i < PerfCounters::EVENTS; i++)
+        counted[i] = false;
+  }
+
+  void reserve(std::size_t batches)
+  {
+    nsPerOp.reserve(nsPerOp.size() + batches);
+  }
+
+  void addAllocations(const AllocationStats& delta)
+  {
+    heap.allocations += delta.allocations;
+    heap.frees += delta.frees;
+    heap.bytesAllocated += delta.bytesAllocated;
+    heap.bytesFreed += delta.bytesFreed;
+  }
+
+  double allocationsPerOp() const
+  {
+    return totalOps ? static_cast<double>(heap.allocations) / totalOps : 0.0;
+  }
+
+  double freesPerOp() const
+  {
+    return totalOps ? static_cast<double>(heap.frees) / totalOps : 0.0;
+  }
+
+  void addEvents(const PerfCounters& counters, const PerfCounters::Reading& delta)
+  {
+    for (std::size_t i = 0; i < PerfCounters::EVENTS; i++)
+    {
+        if (!counters.available(static_cast<PerfCounters::Event>(i)))
+            continue;
+        events.values[i] += delta.values[i];
+        counted[i] = true;
+    }
+  }
+
+  // -1 when the event could not be counted
+  double eventsPerOp(PerfCounters::Event event) const
+  {
+    if (!counted[event])
+        return -1.0;
+    return totalOps ? events.values[event] / totalOps : 0.0;
+  }
+
+  void addKeyCounts(const KeyCounters& delta)
+  {
+    keys.comparisons += delta.comparisons;
+    keys.hashes += delta.hashes;
+    keys.visits += delta.visits;
+  }
+
+  // per operation; 0 unless the map's keys are InstrumentedKeys
+  double keyCountPerOp(std::uint64_t KeyCounters::* count) const
+  {
+    return totalOps ? static_cast<double>(keys.*count) / totalOps : 0.0;
+  }
+
+  void add(Clock::duration elapsed, std::size_t ops)
+  {
+    if (ops == 0)
+        return;
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+    nsPerOp.push_back(ns / ops);
+    totalNs += ns;
+    totalOps += ops;
+    batchOps = std::max(batchOps, ops);
+  }
+
+  std::size_t getOps() const
+  {
+    return totalOps;
+  }
+
+  // operations per sample (of the largest sample, as the last batch of a
+  // run may be short)
+  std::size_t getBatch() const
+  {
+    return batchOps;
+  }
+
+  double mean() const
+  {
+    return totalOps ? totalNs / totalOps : 0.0;
+  }
+
+  // q in [0, 1]; nearest-rank percentile of the batch samples.
+  double percentile(double q) const
+  {
+    if (nsPerOp.empty())
+        return 0.0;
+    std::vector<double> sorted(nsPerOp);
+    std::size_t rank = static_cast<std::size_t>(q * (sorted.size() - 1) + 0.5);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+  }
+};
+
+// Runs body(begin, end) over [0, ops) in slices of batch operations and
+// records the duration of every slice, and the allocations, hardware
+// events and InstrumentedKey counts of all of them. Reading the counters takes system calls, so they
+// are read around the whole run only; the clock reads between slices are
+// counted with it (a few dozen instructions per slice).
+template <typename Body>
+void timeBatches(std::size_t ops, std::size_t batch, Samples& samples, Body body)
+{
+  // reserved up front, so the samples themselves are not counted
+  samples.reserve((ops + batch - 1) / batch);
+  const PerfCounters& counters = PerfCounters::process();
+  const bool counting = counters.available();
+  AllocationStats heapBefore = allocationStats();
+  KeyCounters keysBefore = keyCounters();
+  PerfCounters::Reading eventsBefore = counting ? counters.read() : PerfCounters::Reading();
+  for (std::size_t begin = 0; begin < ops; begin += batch)
+  {
+    std::size_t end = std::min(ops, begin + batch);
+    Clock::time_point start = Clock::now();
+    body(begin, end);
+    samples.add(Clock::now() - start, end - begin);
+  }
+  if (counting)
+    samples.addEvents(counters, counters.read() - eventsBefore);
+  samples.addAllocations(allocationStats() - heapBefore);
+  samples.addKeyCounts(keyCounters() - keysBefore);
+}
+
+struct Result
+{
+  std::string operation;
+  std::string map;
+  std::string distribution;
+  std::size_t size;
+  unsigned int repetitions;
+  double nsPerOp;
+  // median to max are percentiles of per-sample ns/op, each sample the
+  // average of batch operations
+  std::size_t batch;
+  double median;
+  double p99;
+  double p90;
+  double p999;
+  double max;
+  double allocationsPerOp;
+  double freesPerOp;
+  // heap bytes held by a map of size entries, divided by size
+  double bytesPerEntry;
+  // hardware events per operation, -1 where they could not be counted
+  double eventsPerOp[PerfCounters::EVENTS];
+  // key comparisons, hash computations and tree nodes visited per
+  // operation; -1 unless run with --instrumented, visits also for the
+  // standard containers, whose nodes are not seen
+  double comparisonsPerOp;
+  double hashesPerOp;
+  double visitsPerOp;
+  // shape of the filled TreeMap (TreeMap::stats()); -1 for other maps
+  double treeHeight;
+  double averageDepth;
+  // median of the standard container counterpart divided by this median,
+  // 0 when there is none (see assignSpeedups)
+  double speedup;
+};
+
+inline Result summarize(const std::string& operation, const std::string& map,
+                        const std::string& distribution, std::size_t size,
+                        unsigned int repetitions, const Samples& samples,
+                        double bytesPerEntry)
+{
+  Result result;
+  result.operation = operation;
+  result.map = map;
+  result.distribution = distribution;
+  result.size = size;
+  result.repetitions = repetitions;
+  result.nsPerOp = samples.mean();
+  result.batch = samples.getBatch();
+  result.median = samples.percentile(0.5);
+  result.p99 = samples.percentile(0.99);
+  result.p90 = samples.percentile(0.9);
+  result.p999 = samples.percentile(0.999);
+  result.max = samples.percentile(1.0);
+  result.allocationsPerOp = samples.allocationsPerOp();
+  result.freesPerOp = samples.freesPerOp();
+  result.bytesPerEntry = bytesPerEntry;
+  for (std::size_t i = 0; i < PerfCounters::EVENTS; i++)
+    result.eventsPerOp[i] = samples.eventsPerOp(static_cast<PerfCounters::Event>(i));
+  result.comparisonsPerOp = samples.keyCountPerOp(&KeyCounters::comparisons);
+  result.hashesPerOp = samples.keyCountPerOp(&KeyCounters::hashes);
+  result.visitsPerOp = samples.keyCountPerOp(&KeyCounters::visits);
+  result.treeHeight = -1.0;
+  result.averageDepth = -1.0;
+  result.speedup = 0.0;
+  return result;
+}
+
+// The standard container each map is compared with, or "" for the
+// standard containers themselves.
+inline std::string standardCounterpart(const std::string& map)
+{
+  if (map == "tree")
+    return "stdmap";
+  if (map == "hash")
+    return "unordered";
+  return "";
+}
+
+// Fills in speedup for results of one scenario (same operation,
+// distribution and size) whose standard counterpart ran in it too.
+inline void assignSpeedups(std::vector<Result>& scenario)
+{
+  for (Result& result : scenario)
+  {
+    std::string counterpart = standardCounterpart(result.map);
+    for (const Result& other : scenario)
+        if (!counterpart.empty() && other.map == counterpart && result.median > 0)
+            result.speedup = other.median / result.median;
+  }
+}
+
+// One point of a churn run (--churn): the state of a map of liveSize
+// entries after round rounds, each of which replaced churnOps of them.
+struct ChurnSample
+{
+  std::string map;
+  std::size_t liveSize;
+  unsigned int round;
+  // keys replaced so far
+  std::size_t operations;
+  // one remove plus one insert, averaged over this round; 0 for round 0
+  double churnNsPerOp;
+  std::size_t residentBytes;
+  std::size_t heapInUse;
+  std::size_t heapReserved;
+  // requested heap bytes held by the map per live entry
+  double bytesPerEntry;
+  double iterateNsPerEntry;
+};
+
+struct Options
+{
+  std::vector<std::string> operations;
+  std::vector<std::string> maps;
+  std::vector<std::string> distributions;
+  std::vector<std::size_t> sizes;
+  unsigned int repetitions;
+  unsigned int warmup;
+  std::size_t batch;
+  std::uint64_t seed;
+  WorkloadOptions workload;
+  std::string format;
+  std::string output;
+  std::string baseline;
+  double threshold;
+  bool counters;
+  bool churn;
+  unsigned int churnRounds;
+  std::size_t churnOps;
+  std::string record;
+  std::string replay;
+  bool instrumented;
+  bool shape;
+
+  Options()
+    : operations({ "insert", "find", "findMiss", "findMany", "remove", "iterate", "copy" }),
+      maps({ "tree", "hash", "stdmap", "unordered" }),
+      distributions({ "random" }),
+      sizes({ 1000, 10000, 100000, 1000000 }),
+      repetitions(5), warmup(1), batch(64), seed(2016),
+      format("table"), threshold(10.0), counters(true),
+      churn(false), churnRounds(20), churnOps(0), instrumented(false),
+      shape(false)
+  {}
+};
+
+inline std::vector<std::string> splitList(const std::string& text)
+{
+  std::vector<std::string> items;
+  std::stringstream stream(text);
+  std::string item;
+  while (std::getline(stream, item, ','))
+    if (!item.empty())
+        items.push_back(item);
+  return items;
+}
+
+// Accepts plain and scientific notation, e.g. 1000 or 1e3.
+inline std::size_t parseCount(const std::string& text)
+{
+  char * end = nullptr;
+  double value = std::strtod(text.c_str(), &end);
+  if (end == text.c_str() || *end != '\0' || value < 0)
+    throw std::invalid_argument("not a count: " + text);
+  return static_cast<std::size_t>(value + 0.5);
+}
+
+// "1e3:1e6" expands to every power of ten from 1e3 to 1e6.
+inline std::vector<std::size_t> parseSizes(const std::string& text)
+{
+  std::vector<std::size_t> sizes;
+  std::size_t colon = text.find(':');
+  if (colon != std::string::npos)
+  {
+    std::size_t last = parseCount(text.substr(colon + 1));
+    for (std::size_t size = parseCount(text.substr(0, colon)); size && size <= last; size *= 10)
+        sizes.push_back(size);
+    return sizes;
+  }
+  for (const std::string& item : splitList(text))
+    sizes.push_back(parseCount(item));
+  return sizes;
+}
+
+inline void printUsage(std::ostream& out, const char * program)
+{
+  out << "usage: " << program << " [options]\n"
+      << "  --operations=LIST  insert,find,findMiss,findMany,remove,iterate,copy\n"
+      << "                     (findMany is a plain find loop for std maps)\n"
+      << "  --maps=LIST        tree,hash,stdmap,unordered; vs std compares tree\n"
+      << "                     with std::map and hash with std::unordered_map;\n"
+      << "                     hash-pow2, hash-fastrange and hash-prime are hash\n"
+      << "                     with 64, 50 and 53 buckets of the other bucket\n"
+      << "                     policies (not for --replay or --churn)\n"
+      << "  --distributions=LIST\n"
+      << "                     random,sequential,reverse,zipf,clustered,strided\n"
+      << "  --sizes=LIST       e.g. 1e3,1e5 or a decade sweep 1e3:1e8\n"
+      << "  --repetitions=N    timed runs per scenario (default 5)\n"
+      << "  --warmup=N         untimed runs before them (default 1)\n"
+      << "  --batch=N          operations per timing sample (default 64); the\n"
+      << "                     percentile columns are over these samples, so 1\n"
+      << "                     gives per-operation latencies\n"
+      << "  --seed=N           key generator seed\n"
+      << "  --zipf-theta=X     skew of zipf lookups (default 0.99)\n"
+      << "  --stride=N         distance of strided keys (default 50)\n"
+      << "  --cluster-size=N   keys per clustered run (default 64)\n"
+      << "  --format=F         table, csv or json (default table)\n"
+      << "  --output=FILE      write results there instead of stdout\n"
+      << "  --baseline=FILE    compare with a stored --format=csv run and exit\n"
+      << "                     with status 2 if any median got slower by more\n"
+      << "  --threshold=P      than P percent (default 10)\n"
+      << "  --no-counters      skip the hardware event counters (perf_event_open),\n"
+      << "                     which are left out anyway where unavailable\n"
+      << "  --churn            instead of the operations, keep every map at each\n"
+      << "                     of --sizes live random keys and replace keys\n"
+      << "                     (remove one, insert a new one), sampling RSS, heap,\n"
+      << "                     bytes per entry and iteration speed after each round\n"
+      << "  --churn-rounds=N   rounds of a churn run (default 20)\n"
+      << "  --churn-ops=N      keys replaced per round (default: the live size)\n"
+      << "  --record=FILE      write a trace of a synthetic run over the first\n"
+      << "                     distribution and size to FILE and exit\n"
+      << "  --replay=FILE      instead of the operations, run the trace in FILE\n"
+      << "                     against every map (operation \"replay\")\n"
+      << "  --instrumented     run the operations with keys that count comparisons,\n"
+      << "                     hashes and tree node visits, and report them per\n"
+      << "                     operation (times include the counting)\n"
+      << "  --shape            print the shape of a TreeMap of every distribution and\n"
+      << "                     size: depths and balance factors (table format; csv and\n"
+      << "                     json always carry height and average depth)\n";
+}
+
+// Parses --name=value arguments. Throws std::invalid_argument on anything
+// it does not understand.
+// Throws unless every name is one of known; what names the option.
+inline void checkNames(const std::vector<std::string>& names,
+                       const std::vector<std::string>& known, const std::string& what)
+{
+  for (const std::string& name : names)
+    if (std::find(known.begin(), known.end(), name) == known.end())
+        throw std::invalid_argument("unknown " + what + ": " + name);
+}
+
+inline Options parseOptions(int argc, char * argv[])
+{
+  Options options;
+  for (int i = 1; i < argc; i++)
+  {
+    std::string argument(argv[i]);
+    std::size_t equals = argument.find('=');
+    std::string name = argument.substr(0, equals);
+    std::string value = equals == std::string::npos ? "" : argument.substr(equals + 1);
+    if (name == "--operations")
+        options.operations = splitList(value);
+    else if (name == "--maps")
+        options.maps = splitList(value);
+    else if (name == "--distributions")
+        options.distributions = splitList(value);
+    else if (name == "--sizes")
+        options.sizes = parseSizes(value);
+    else if (name == "--repetitions")
+        options.repetitions = parseCount(value);
+    else if (name == "--warmup")
+        options.warmup = parseCount(value);
+    else if (name == "--batch")
+        options.batch = std::max<std::size_t>(1, parseCount(value));
+    else if (name == "--seed")
+        options.seed = std::strtoull(value.c_str(), nullptr, 10);
+    else if (name == "--zipf-theta")
+        options.workload.zipfTheta = std::strtod(value.c_str(), nullptr);
+    else if (name == "--stride")
+        options.workload.stride = parseCount(value);
+    else if (name == "--cluster-size")
+        options.workload.clusterSize = parseCount(value);
+    else if (name == "--format")
+        options.format = value;
+    else if (name == "--output")
+        options.output = value;
+    else if (name == "--baseline")
+        options.baseline = value;
+    else if (name == "--threshold")
+        options.threshold = std::strtod(value.c_str(), nullptr);
+    else if (argument == "--no-counters")
+        options.counters = false;
+    else if (argument == "--churn")
+        options.churn = true;
+    else if (name == "--churn-rounds")
+        options.churnRounds = parseCount(value);
+    else if (name == "--churn-ops")
+        options.churnOps = parseCount(value);
+    else if (name == "--record")
+        options.record = value;
+    else if (name == "--replay")
+        options.replay = value;
+    else if (argument == "--instrumented")
+        options.instrumented = true;
+    else if (argument == "--shape")
+        options.shape = true;
+    else
+        throw std::invalid_argument("unknown option: " + argument);
+  }
+  if (options.repetitions == 0)
+    throw std::invalid_argument("--repetitions must be positive");
+  if (options.format != "table" && options.format != "csv" && options.format != "json")
+    throw std::invalid_argument("unknown format: " + options.format);
+  // checked here rather than when the benchmark reaches them, so that a
+  // typo is reported with the usage before anything runs
+  checkNames(options.operations,
+             { "insert", "find", "findMiss", "findMany", "remove", "iterate", "copy" }, "operation");
+  checkNames(options.distributions, workloadDistributions(), "distribution");
+  if (options.churn || !options.replay.empty())
+    checkNames(options.maps, { "tree", "hash", "stdmap", "unordered" },
+               options.churn ? "map for --churn" : "map for --replay");
+  else
+    checkNames(options.maps, { "tree", "hash", "hash-pow2", "hash-fastrange", "hash-prime",
+                               "stdmap", "unordered" }, "map");
+  return options;
+}
+
+}
+}
+
+#endif /* AISDI_MAPS_BENCHMARK_H */
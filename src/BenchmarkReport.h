@@ -0,0 +1,408 @@
+#ifndef AISDI_MAPS_BENCHMARKREPORT_H
+#define AISDI_MAPS_BENCHMARKREPORT_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <Benchmark.h>
+#include <MemoryUsage.h>
+#include <TreeMap.h>
+
+namespace aisdi
+{
+namespace benchmark
+{
+
+// events adds the hardware counter columns, keys the InstrumentedKey
+// ones (all per operation). median to max are percentiles over batches
+// of the given number of operations, which the header says when it is
+// more than one.
+inline void printHeader(std::ostream& out, bool events, bool keys, std::size_t batch)
+{
+  if (batch > 1)
+    out << "median to max: ns/op percentiles of batches of " << batch
+        << " operations, not of single operations (see --batch)" << std::endl;
+  out << std::left << std::setw(10) << "operation" << std::setw(15) << "map"
+      << std::setw(11) << "keys"
+      << std::right << std::setw(11) << "size" << std::setw(6) << "reps"
+      << std::setw(9) << "ns/op" << std::setw(7) << "batch" << std::setw(9) << "median" << std::setw(9) << "p90"
+      << std::setw(9) << "p99" << std::setw(9) << "p99.9" << std::setw(9) << "max"
+      << std::setw(10) << "allocs/op" << std::setw(9) << "B/entry" << std::setw(8) << "vs std";
+  if (keys)
+    out << std::setw(9) << "compares" << std::setw(8) << "hashes" << std::setw(8) << "visits";
+  if (events)
+    out << std::setw(9) << "cycles" << std::setw(9) << "instr" << std::setw(8) << "L1d"
+        << std::setw(8) << "LLC" << std::setw(8) << "br-miss" << std::setw(8) << "dTLB";
+  out << std::endl;
+}
+
+inline void printResult(std::ostream& out, const Result& result, bool events, bool keys)
+{
+  auto optional = [&](int width, double value)
+  {
+    if (value < 0)
+        out << std::setw(width) << "-";
+    else
+        out << std::setw(width) << value;
+  };
+  out << std::left << std::setw(10) << result.operation << std::setw(15) << result.map
+      << std::setw(11) << result.distribution
+      << std::right << std::setw(11) << result.size << std::setw(6) << result.repetitions
+      << std::fixed << std::setprecision(1)
+      << std::setw(9) << result.nsPerOp << std::setw(7) << result.batch << std::setw(9) << result.median
+      << std::setw(9) << result.p90 << std::setw(9) << result.p99
+      << std::setw(9) << result.p999 << std::setw(9) << result.max
+      << std::setprecision(2) << std::setw(10) << result.allocationsPerOp
+      << std::setprecision(1) << std::setw(9) << result.bytesPerEntry << std::setprecision(2);
+  if (result.speedup > 0)
+    out << std::setw(7) << result.speedup << 'x';
+  else
+    out << std::setw(8) << "-";
+  out << std::setprecision(1);
+  if (keys)
+  {
+    optional(9, result.comparisonsPerOp);
+    optional(8, result.hashesPerOp);
+    optional(8, result.visitsPerOp);
+  }
+  if (events)
+  {
+    for (std::size_t i = 0; i < PerfCounters::EVENTS; i++)
+        optional(i < PerfCounters::L1dMisses ? 9 : 8, result.eventsPerOp[i]);
+  }
+  out << std::endl;
+}
+
+// Column order of the CSV output; readCsv looks columns up by name, so
+// files written by older versions with fewer columns still load.
+inline const std::vector<std::string>& csvColumns()
+{
+  static const std::vector<std::string> columns =
+    { "operation", "map", "distribution", "size", "repetitions",
+      "ns_per_op", "p50_ns", "p99_ns", "allocations_per_op", "speedup_vs_std",
+      "p90_ns", "p999_ns", "max_ns", "frees_per_op", "bytes_per_entry",
+      "cycles_per_op", "instructions_per_op", "l1d_misses_per_op", "llc_misses_per_op",
+      "branch_misses_per_op", "dtlb_misses_per_op",
+      "comparisons_per_op", "hashes_per_op", "visits_per_op", "tree_height", "average_depth",
+      "batch_ops" };
+  return columns;
+}
+
+// Column name of an event in CSV and JSON.
+inline std::string eventColumn(PerfCounters::Event event)
+{
+  return std::string(PerfCounters::eventName(event)) + "_per_op";
+}
+
+inline void writeCsv(std::ostream& out, const std::vector<Result>& results)
+{
+  const std::vector<std::string>& columns = csvColumns();
+  for (std::size_t i = 0; i < columns.size(); i++)
+    out << (i ? "," : "") << columns[i];
+  out << "\n";
+  for (const Result& result : results)
+  {
+    out << result.operation << ',' << result.map << ',' << result.distribution << ','
+        << result.size << ',' << result.repetitions << ','
+        << std::setprecision(6) << result.nsPerOp << ',' << result.median << ','
+        << result.p99 << ',' << result.allocationsPerOp << ',' << result.speedup << ','
+        << result.p90 << ',' << result.p999 << ',' << result.max << ','
+        << result.freesPerOp << ',' << result.bytesPerEntry;
+    // uncounted events and key counts stay empty
+    auto optional = [&](double value)
+    {
+      out << ',';
+      if (value >= 0)
+          out << value;
+    };
+    for (std::size_t i = 0; i < PerfCounters::EVENTS; i++)
+        optional(result.eventsPerOp[i]);
+    optional(result.comparisonsPerOp);
+    optional(result.hashesPerOp);
+    optional(result.visitsPerOp);
+    optional(result.treeHeight);
+    optional(result.averageDepth);
+    out << ',' << result.batch << "\n";
+  }
+}
+
+inline void writeJson(std::ostream& out, const std::vector<Result>& results)
+{
+  out << "[\n";
+  for (std::size_t i = 0; i < results.size(); i++)
+  {
+    const Result& result = results[i];
+    out << "  {\"operation\": \"" << result.operation << "\", \"map\": \"" << result.map
+        << "\", \"distribution\": \"" << result.distribution << "\", \"size\": " << result.size
+        << ", \"repetitions\": " << result.repetitions << std::setprecision(6)
+        << ", \"ns_per_op\": " << result.nsPerOp << ", \"batch_ops\": " << result.batch
+        << ", \"p50_ns\": " << result.median
+        << ", \"p90_ns\": " << result.p90 << ", \"p99_ns\": " << result.p99
+        << ", \"p999_ns\": " << result.p999 << ", \"max_ns\": " << result.max
+        << ", \"allocations_per_op\": " << result.allocationsPerOp
+        << ", \"frees_per_op\": " << result.freesPerOp
+        << ", \"bytes_per_entry\": " << result.bytesPerEntry
+        << ", \"speedup_vs_std\": " << result.speedup;
+    auto optional = [&](const std::string& name, double value)
+    {
+      out << ", \"" << name << "\": ";
+      if (value >= 0)
+          out << value;
+      else
+          out << "null";
+    };
+    for (std::size_t e = 0; e < PerfCounters::EVENTS; e++)
+        optional(eventColumn(static_cast<PerfCounters::Event>(e)), result.eventsPerOp[e]);
+    optional("comparisons_per_op", result.comparisonsPerOp);
+    optional("hashes_per_op", result.hashesPerOp);
+    optional("visits_per_op", result.visitsPerOp);
+    optional("tree_height", result.treeHeight);
+    optional("average_depth", result.averageDepth);
+    out << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+  out << "]\n";
+}
+
+// Shape of a TreeMap holding the keys of one distribution: how far its
+// height is from a balanced tree's, depth percentiles and how the balance
+// factors are spread.
+inline void printTreeStats(std::ostream& out, const std::string& distribution, const TreeStats& stats)
+{
+  auto depthPercentile = [&](double q)
+  {
+    std::size_t rank = static_cast<std::size_t>(q * stats.size);
+    std::size_t seen = 0;
+    for (std::size_t depth = 0; depth < stats.depthHistogram.size(); depth++)
+    {
+        seen += stats.depthHistogram[depth];
+        if (seen > rank)
+            return depth;
+    }
+    return stats.maxDepth;
+  };
+  std::size_t leftHeavy = 0;
+  std::size_t rightHeavy = 0;
+  for (const auto& factor : stats.balanceFactors)
+  {
+    if (factor.first < -1)
+        leftHeavy += factor.second;
+    else if (factor.first > 1)
+        rightHeavy += factor.second;
+  }
+  auto count = [&](long factor)
+  {
+    auto found = stats.balanceFactors.find(factor);
+    return found == stats.balanceFactors.end() ? 0 : found->second;
+  };
+  out << "tree shape, " << distribution << " keys, " << stats.size << " entries: height "
+      << stats.height << " (balanced " << stats.minimalHeight() << "), depth avg "
+      << std::fixed << std::setprecision(1) << stats.averageDepth
+      << " p50 " << depthPercentile(0.5) << " p90 " << depthPercentile(0.9)
+      << " p99 " << depthPercentile(0.99) << " max " << stats.maxDepth << "\n"
+      << "  balance factors <-1: " << leftHeavy << "  -1: " << count(-1) << "  0: " << count(0)
+      << "  +1: " << count(1) << "  >+1: " << rightHeavy << "; node bytes " << stats.nodeBytes
+      << std::endl;
+}
+
+inline void printChurnHeader(std::ostream& out)
+{
+  out << std::left << std::setw(10) << "map" << std::right << std::setw(10) << "live"
+      << std::setw(6) << "round" << std::setw(12) << "replaced" << std::setw(10) << "churn ns"
+      << std::setw(10) << "RSS MiB" << std::setw(10) << "heap MiB" << std::setw(11) << "arena MiB"
+      << std::setw(7) << "frag%" << std::setw(9) << "B/entry" << std::setw(10) << "iter ns"
+      << std::endl;
+}
+
+inline void printChurnSample(std::ostream& out, const ChurnSample& sample)
+{
+  const double mebibyte = 1024.0 * 1024.0;
+  HeapUsage heap = { sample.heapInUse, sample.heapReserved };
+  out << std::left << std::setw(10) << sample.map << std::right << std::setw(10) << sample.liveSize
+      << std::setw(6) << sample.round << std::setw(12) << sample.operations
+      << std::fixed << std::setprecision(1) << std::setw(10) << sample.churnNsPerOp
+      << std::setw(10) << sample.residentBytes / mebibyte
+      << std::setw(10) << sample.heapInUse / mebibyte
+      << std::setw(11) << sample.heapReserved / mebibyte
+      << std::setw(7) << heap.fragmentation() * 100.0
+      << std::setw(9) << sample.bytesPerEntry << std::setw(10) << sample.iterateNsPerEntry
+      << std::endl;
+}
+
+// Per map and live size: how RSS, allocator reserve, fragmentation and
+// iteration speed moved between the freshly filled map and the last round.
+inline void printChurnSummary(std::ostream& out, const std::vector<ChurnSample>& samples)
+{
+  out << "\n" << std::left << std::setw(10) << "map" << std::right << std::setw(10) << "live"
+      << std::setw(12) << "RSS growth" << std::setw(14) << "arena growth"
+      << std::setw(18) << "frag% first/last" << std::setw(16) << "iter slowdown" << std::endl;
+  for (std::size_t first = 0; first < samples.size();)
+  {
+    std::size_t last = first;
+    while (last + 1 < samples.size() && samples[last + 1].map == samples[first].map
+           && samples[last + 1].liveSize == samples[first].liveSize)
+        last++;
+    const ChurnSample& before = samples[first];
+    const ChurnSample& after = samples[last];
+    auto ratio = [](double now, double then) { return then > 0 ? now / then : 0.0; };
+    HeapUsage heapBefore = { before.heapInUse, before.heapReserved };
+    HeapUsage heapAfter = { after.heapInUse, after.heapReserved };
+    std::ostringstream fragmentation;
+    fragmentation << std::fixed << std::setprecision(1) << heapBefore.fragmentation() * 100.0
+                  << '/' << heapAfter.fragmentation() * 100.0;
+    out << std::left << std::setw(10) << before.map << std::right << std::setw(10) << before.liveSize
+        << std::fixed << std::setprecision(2)
+        << std::setw(11) << ratio(after.residentBytes, before.residentBytes) << 'x'
+        << std::setw(13) << ratio(after.heapReserved, before.heapReserved) << 'x'
+        << std::setw(18) << fragmentation.str()
+        << std::setw(15) << ratio(after.iterateNsPerEntry, before.iterateNsPerEntry) << 'x'
+        << std::endl;
+    first = last + 1;
+  }
+}
+
+inline void writeChurnCsv(std::ostream& out, const std::vector<ChurnSample>& samples)
+{
+  out << "map,live_size,round,replaced,churn_ns_per_op,rss_bytes,heap_in_use_bytes,"
+      << "heap_reserved_bytes,bytes_per_entry,iterate_ns_per_entry\n";
+  for (const ChurnSample& sample : samples)
+  {
+    out << sample.map << ',' << sample.liveSize << ',' << sample.round << ','
+        << sample.operations << ',' << std::setprecision(6) << sample.churnNsPerOp << ','
+        << sample.residentBytes << ',' << sample.heapInUse << ',' << sample.heapReserved << ','
+        << sample.bytesPerEntry << ',' << sample.iterateNsPerEntry << "\n";
+  }
+}
+
+inline void writeChurnJson(std::ostream& out, const std::vector<ChurnSample>& samples)
+{
+  out << "[\n";
+  for (std::size_t i = 0; i < samples.size(); i++)
+  {
+    const ChurnSample& sample = samples[i];
+    out << "  {\"map\": \"" << sample.map << "\", \"live_size\": " << sample.liveSize
+        << ", \"round\": " << sample.round << ", \"replaced\": " << sample.operations
+        << std::setprecision(6) << ", \"churn_ns_per_op\": " << sample.churnNsPerOp
+        << ", \"rss_bytes\": " << sample.residentBytes
+        << ", \"heap_in_use_bytes\": " << sample.heapInUse
+        << ", \"heap_reserved_bytes\": " << sample.heapReserved
+        << ", \"bytes_per_entry\": " << sample.bytesPerEntry
+        << ", \"iterate_ns_per_entry\": " << sample.iterateNsPerEntry << "}"
+        << (i + 1 < samples.size() ? ",\n" : "\n");
+  }
+  out << "]\n";
+}
+
+// Reads results written by writeCsv.
+inline std::vector<Result> readCsv(std::istream& in)
+{
+  std::vector<Result> results;
+  std::string line;
+  if (!std::getline(in, line))
+    return results;
+  std::map<std::string, std::size_t> column;
+  std::vector<std::string> header = splitList(line);
+  for (std::size_t i = 0; i < header.size(); i++)
+    column[header[i]] = i;
+  for (const char * name : { "operation", "map", "distribution", "size", "p50_ns" })
+    if (!column.count(name))
+        throw std::invalid_argument(std::string("baseline lacks column ") + name);
+
+  while (std::getline(in, line))
+  {
+    if (line.empty())
+        continue;
+    std::vector<std::string> fields;
+    std::stringstream stream(line);
+    std::string field;
+    while (std::getline(stream, field, ','))
+        fields.push_back(field);
+    fields.resize(header.size());
+    auto number = [&](const char * name)
+    {
+      return column.count(name) ? std::strtod(fields[column[name]].c_str(), nullptr) : 0.0;
+    };
+    Result result;
+    result.operation = fields[column["operation"]];
+    result.map = fields[column["map"]];
+    result.distribution = fields[column["distribution"]];
+    result.size = static_cast<std::size_t>(number("size"));
+    result.repetitions = static_cast<unsigned int>(number("repetitions"));
+    result.nsPerOp = number("ns_per_op");
+    result.batch = static_cast<std::size_t>(number("batch_ops"));
+    result.median = number("p50_ns");
+    result.p99 = number("p99_ns");
+    result.p90 = number("p90_ns");
+    result.p999 = number("p999_ns");
+    result.max = number("max_ns");
+    // empty or missing columns were not counted
+    auto optional = [&](const std::string& name)
+    {
+      bool counted = column.count(name) && !fields[column[name]].empty();
+      return counted ? number(name.c_str()) : -1.0;
+    };
+    for (std::size_t e = 0; e < PerfCounters::EVENTS; e++)
+        result.eventsPerOp[e] = optional(eventColumn(static_cast<PerfCounters::Event>(e)));
+    result.comparisonsPerOp = optional("comparisons_per_op");
+    result.hashesPerOp = optional("hashes_per_op");
+    result.visitsPerOp = optional("visits_per_op");
+    result.treeHeight = optional("tree_height");
+    result.averageDepth = optional("average_depth");
+    result.allocationsPerOp = number("allocations_per_op");
+    result.freesPerOp = number("frees_per_op");
+    result.bytesPerEntry = number("bytes_per_entry");
+    result.speedup = number("speedup_vs_std");
+    results.push_back(result);
+  }
+  return results;
+}
+
+// Prints how every current result's median changed against the baseline
+// result of the same operation, map, distribution and size. Returns true
+// when at least one got slower by more than thresholdPercent.
+inline bool compareWithBaseline(std::ostream& out, const std::vector<Result>& baseline,
+                                const std::vector<Result>& current, double thresholdPercent)
+{
+  std::map<std::string, const Result*> byScenario;
+  auto scenario = [](const Result& result)
+  {
+    std::ostringstream name;
+    name << result.operation << '/' << result.map << '/' << result.distribution << '/' << result.size;
+    return name.str();
+  };
+  for (const Result& result : baseline)
+    byScenario[scenario(result)] = &result;
+
+  bool regressed = false;
+  out << std::left << std::setw(40) << "scenario" << std::right << std::setw(12) << "baseline"
+      << std::setw(12) << "current" << std::setw(10) << "change" << std::endl;
+  for (const Result& result : current)
+  {
+    auto found = byScenario.find(scenario(result));
+    out << std::left << std::setw(40) << scenario(result) << std::right << std::fixed
+        << std::setprecision(1);
+    if (found == byScenario.end() || found->second->median <= 0)
+    {
+        out << std::setw(12) << "-" << std::setw(12) << result.median << std::setw(10) << "new"
+            << std::endl;
+        continue;
+    }
+    double change = (result.median / found->second->median - 1.0) * 100.0;
+    bool slower = change > thresholdPercent;
+    regressed = regressed || slower;
+    out << std::setw(12) << found->second->median << std::setw(12) << result.median
+        << std::setw(9) << std::showpos << change << std::noshowpos << '%'
+        << (slower ? "  REGRESSION" : "") << std::endl;
+  }
+  return regressed;
+}
+
+}
+}
+
+#endif /* AISDI_MAPS_BENCHMARKREPORT_H */
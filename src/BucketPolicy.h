@@ -0,0 +1,105 @@
+#ifndef AISDI_MAPS_BUCKETPOLICY_H
+#define AISDI_MAPS_BUCKETPOLICY_H
+
+#include <cstdint>
+
+namespace aisdi
+{
+
+// The integer HashMap buckets a key by: the key itself. Key types that
+// are not integers overload it in their own namespace.
+template <typename KeyType>
+constexpr std::uint64_t bucketHash(const KeyType& key)
+{
+  return static_cast<std::uint64_t>(key);
+}
+
+// Bucket policies: the last template parameter of HashMap, fixing the
+// number of buckets at compile time and mapping a key's bucketHash() to
+// one of them. With the count a constant, no policy needs a division
+// instruction.
+
+// hash % N, the original HashMap buckets with N = 50. The compiler turns
+// the division by a constant into a multiply and shifts.
+template <unsigned int N>
+struct ModuloBuckets
+{
+  static_assert(N > 0, "at least one bucket");
+  static constexpr unsigned int COUNT = N;
+
+  static unsigned int index(std::uint64_t hash)
+  {
+    return static_cast<unsigned int>(hash % N);
+  }
+};
+
+template <unsigned int N>
+constexpr unsigned int ModuloBuckets<N>::COUNT;
+
+// The low bits of the hash: a single AND. Sequential keys spread
+// perfectly; keys that differ only in their high bits (strided ids) all
+// land in the same bucket.
+template <unsigned int N>
+struct PowerOfTwoBuckets
+{
+  static_assert(N > 0 && (N & (N - 1)) == 0, "bucket count must be a power of two");
+  static constexpr unsigned int COUNT = N;
+
+  static unsigned int index(std::uint64_t hash)
+  {
+    return static_cast<unsigned int>(hash & (N - 1));
+  }
+};
+
+template <unsigned int N>
+constexpr unsigned int PowerOfTwoBuckets<N>::COUNT;
+
+// Lemire's fast range reduction, (x * N) >> 32 for a 32-bit x, which
+// picks the bucket by the high bits of x. Raw integer keys are small, so
+// x is first taken from the upper half of a Fibonacci hash
+// (ConcurrentHashMap picks its shards the same way): two multiplies, any
+// bucket count.
+template <unsigned int N>
+struct FastRangeBuckets
+{
+  static_assert(N > 0, "at least one bucket");
+  static constexpr unsigned int COUNT = N;
+
+  static unsigned int index(std::uint64_t hash)
+  {
+    std::uint64_t x = (hash * 0x9E3779B97F4A7C15ull) >> 32;
+    return static_cast<unsigned int>((x * N) >> 32);
+  }
+};
+
+template <unsigned int N>
+constexpr unsigned int FastRangeBuckets<N>::COUNT;
+
+// hash % P computed with Lemire's fastmod: a multiplier precomputed from
+// P and two multiplies instead of a division (exact for every 32-bit
+// dividend, so the 64-bit hash is folded to 32 bits first). A prime P
+// spreads strided keys evenly, but any P works.
+template <unsigned int P>
+struct PrimeBuckets
+{
+  static_assert(P > 1, "at least two buckets");
+  static constexpr unsigned int COUNT = P;
+  static constexpr std::uint64_t MAGIC = UINT64_C(0xFFFFFFFFFFFFFFFF) / P + 1;
+
+  static unsigned int index(std::uint64_t hash)
+  {
+    __extension__ typedef unsigned __int128 Wide;
+    std::uint32_t folded = static_cast<std::uint32_t>(hash ^ (hash >> 32));
+    std::uint64_t fraction = MAGIC * folded;
+    return static_cast<unsigned int>((static_cast<Wide>(fraction) * P) >> 64);
+  }
+};
+
+template <unsigned int P>
+constexpr unsigned int PrimeBuckets<P>::COUNT;
+template <unsigned int P>
+constexpr std::uint64_t PrimeBuckets<P>::MAGIC;
+
+}
+
+#endif /* AISDI_MAPS_BUCKETPOLICY_H */
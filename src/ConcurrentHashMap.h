@@ -0,0 +1,219 @@
+#ifndef AISDI_MAPS_CONCURRENTHASHMAP_H
+#define AISDI_MAPS_CONCURRENTHASHMAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+#include <HashMap.h>
+
+namespace aisdi
+{
+
+// Reader-writer spin lock. Any number of readers may hold it together,
+// a writer holds it alone. A waiting writer blocks new readers, so a steady
+// stream of lookups cannot starve updates.
+class SharedSpinLock
+{
+private:
+  static const unsigned int WRITER = 1u << 31;
+  static const unsigned int PENDING = 1u << 30;
+
+  std::atomic<unsigned int> state;
+
+public:
+  SharedSpinLock() : state(0)
+  {}
+
+  SharedSpinLock(const SharedSpinLock&) = delete;
+  SharedSpinLock& operator=(const SharedSpinLock&) = delete;
+
+  void lock()
+  {
+    for (;;)
+    {
+        unsigned int current = state.load(std::memory_order_relaxed);
+        if ((current & ~PENDING) == 0
+            && state.compare_exchange_weak(current, WRITER, std::memory_order_acquire))
+            return;
+        if (!(current & PENDING))
+            state.fetch_or(PENDING, std::memory_order_relaxed);
+        std::this_thread::yield();
+    }
+  }
+
+  void unlock()
+  {
+    state.store(0, std::memory_order_release);
+  }
+
+  void lock_shared()
+  {
+    for (;;)
+    {
+        unsigned int current = state.load(std::memory_order_relaxed);
+        if (!(current & (WRITER | PENDING))
+            && state.compare_exchange_weak(current, current + 1, std::memory_order_acquire))
+            return;
+        std::this_thread::yield();
+    }
+  }
+
+  void unlock_shared()
+  {
+    state.fetch_sub(1, std::memory_order_release);
+  }
+};
+
+// Thread-safe hash map made of independently locked shards. Each shard owns
+// a whole HashMap (its own bucket array), so threads working on different
+// shards never touch the same lock or the same memory.
+// Values are copied out of the map - references would outlive the lock.
+// The shard locks are held by scoped guards, so an exception thrown by a
+// key or value copy, or by computeIfAbsent's factory, releases them.
+template <typename KeyType, typename ValueType>
+class ConcurrentHashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using size_type = std::size_t;
+
+private:
+  struct Shard
+  {
+    SharedSpinLock lock;
+    HashMap<KeyType, ValueType> map;
+    // keeps neighbouring shards' locks on separate cache lines
+    char padding[64];
+  };
+
+  using WriteGuard = std::lock_guard<SharedSpinLock>;
+  using ReadGuard = std::shared_lock<SharedSpinLock>;
+
+  std::unique_ptr<Shard[]> shards;
+  size_type shardCount;
+
+  // Fibonacci hashing on the upper half of the product, so shard selection
+  // is independent of the key % BUCKETS used inside each shard.
+  Shard& shardOf(const key_type& key) const
+  {
+    std::uint64_t x = static_cast<std::uint64_t>(key) * 0x9E3779B97F4A7C15ull;
+    return shards[(x >> 32) & (shardCount - 1)];
+  }
+
+  static size_type roundUpToPowerOfTwo(size_type n)
+  {
+    size_type result = 1;
+    while (result < n)
+        result <<= 1;
+    return result;
+  }
+
+public:
+  explicit ConcurrentHashMap(size_type shardHint = 16)
+    : shards(new Shard[roundUpToPowerOfTwo(shardHint)]), shardCount(roundUpToPowerOfTwo(shardHint))
+  {}
+
+  ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+  ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+
+  // Returns true if the key was inserted, false if an existing value was replaced.
+  bool insertOrAssign(const key_type& key, const mapped_type& value)
+  {
+    Shard& shard = shardOf(key);
+    WriteGuard guard(shard.lock);
+    auto result = shard.map.insertOrGet(key);
+    result.first->second = value;
+    return result.second;
+  }
+
+  // Copies the value into out and returns true when the key is present.
+  bool find(const key_type& key, mapped_type& out) const
+  {
+    Shard& shard = shardOf(key);
+    ReadGuard guard(shard.lock);
+    const mapped_type * value = shard.map.tryGet(key);
+    if (value)
+        out = *value;
+    return value != nullptr;
+  }
+
+  bool contains(const key_type& key) const
+  {
+    Shard& shard = shardOf(key);
+    ReadGuard guard(shard.lock);
+    return shard.map.contains(key);
+  }
+
+  // Returns true if the key was present.
+  bool remove(const key_type& key)
+  {
+    Shard& shard = shardOf(key);
+    WriteGuard guard(shard.lock);
+    auto it = shard.map.find(key);
+    bool found = (it != shard.map.end());
+    if (found)
+        shard.map.remove(it);
+    return found;
+  }
+
+  // Returns the value stored under key, calling factory(key) to create it
+  // if the key is missing. The factory runs with the shard locked, so it is
+  // called at most once per key and must not use this map.
+  template <typename Factory>
+  mapped_type computeIfAbsent(const key_type& key, Factory factory)
+  {
+    mapped_type result;
+    if (find(key, result))
+        return result;
+    Shard& shard = shardOf(key);
+    WriteGuard guard(shard.lock);
+    const mapped_type * value = shard.map.tryGet(key);
+    if (value)
+        return *value;
+    result = factory(key);
+    shard.map[key] = result;
+    return result;
+  }
+
+  // Shards are counted one after another, so under concurrent updates the
+  // result is not an atomic snapshot.
+  size_type getSize() const
+  {
+    size_type total = 0;
+    for (size_type i = 0; i < shardCount; i++)
+    {
+        ReadGuard guard(shards[i].lock);
+        total += shards[i].map.getSize();
+    }
+    return total;
+  }
+
+  bool isEmpty() const
+  {
+    return getSize() == 0;
+  }
+
+  void clear()
+  {
+    for (size_type i = 0; i < shardCount; i++)
+    {
+        WriteGuard guard(shards[i].lock);
+        shards[i].map.clear();
+    }
+  }
+
+  size_type getShardCount() const
+  {
+    return shardCount;
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_CONCURRENTHASHMAP_H */
@@ -0,0 +1,192 @@
+#ifndef AISDI_MAPS_EVENTHOOKS_H
+#define AISDI_MAPS_EVENTHOOKS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <thread>
+
+namespace aisdi
+{
+
+// An expensive whole-map operation, reported once it has finished.
+struct MapEvent
+{
+  enum Kind
+  {
+    Clear,     // clear(), and the old contents dropped by an assignment
+    Destroy,   // destructor
+    Copy       // copy construction or copy assignment
+  };
+
+  Kind kind;
+  // "TreeMap" or "HashMap"
+  const char * map;
+  const void * instance;
+  // entries freed or copied; a copy assignment counts both
+  std::size_t elements;
+  std::chrono::steady_clock::time_point start;
+  std::chrono::steady_clock::duration duration;
+
+  static const char * kindName(Kind kind)
+  {
+    static const char * const names[] = { "clear", "destroy", "copy" };
+    return names[kind];
+  }
+};
+
+// Process-wide hook for MapEvents of every TreeMap and HashMap. Without a
+// hook an event costs one relaxed atomic load. Install and remove the hook
+// while no other thread uses maps; once installed it is called from
+// whichever thread ran the event, so it must be thread-safe itself.
+class MapEvents
+{
+public:
+  using Hook = std::function<void(const MapEvent&)>;
+
+private:
+  struct State
+  {
+    std::atomic<bool> installed;
+    Hook hook;
+    std::size_t minElements;
+  };
+
+  static State& state()
+  {
+    static State state = { { false }, Hook(), 0 };
+    return state;
+  }
+
+  // events already being timed on this thread; the maps' own nested
+  // operations (a HashMap's buckets, the clear inside an assignment) are
+  // part of them and not reported again
+  static int& depth()
+  {
+    static thread_local int depth = 0;
+    return depth;
+  }
+
+  template <typename Key, typename Value, typename Stats> friend class TreeMap;
+  template <typename Key, typename Value, typename Stats, typename Buckets> friend class HashMap;
+
+  // Times the scope it lives in and reports it on destruction, if a hook
+  // is installed and elements reaches its threshold.
+  class Scope
+  {
+  private:
+    MapEvent event;
+    bool active;
+
+  public:
+    Scope(MapEvent::Kind kind, const char * map, const void * instance, std::size_t elements)
+      : active(false)
+    {
+      State& events = state();
+      if (!events.installed.load(std::memory_order_relaxed) || elements == 0
+          || elements < events.minElements || depth() > 0)
+          return;
+      active = true;
+      depth()++;
+      event.kind = kind;
+      event.map = map;
+      event.instance = instance;
+      event.elements = elements;
+      event.start = std::chrono::steady_clock::now();
+    }
+
+    ~Scope()
+    {
+      if (!active)
+          return;
+      event.duration = std::chrono::steady_clock::now() - event.start;
+      depth()--;
+      state().hook(event);
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  };
+
+public:
+  // Reports events on at least minElements entries to hook. Events on
+  // empty maps are never reported.
+  static void setHook(Hook hook, std::size_t minElements = 0)
+  {
+    State& events = state();
+    events.installed.store(false, std::memory_order_relaxed);
+    events.hook = std::move(hook);
+    events.minElements = minElements;
+    events.installed.store(static_cast<bool>(events.hook), std::memory_order_release);
+  }
+
+  static void removeHook()
+  {
+    setHook(Hook());
+  }
+};
+
+// Hook writing events in the Chrome trace event format (complete "X"
+// events), for chrome://tracing or Perfetto:
+//
+//   std::ofstream file("maps.json");
+//   ChromeTraceWriter trace(file);
+//   MapEvents::setHook(std::ref(trace), 10000);
+//
+// Timestamps are microseconds since the writer was created. The JSON
+// array is closed by the destructor, so remove the hook first.
+class ChromeTraceWriter
+{
+private:
+  std::ostream& out;
+  std::mutex mutex;
+  std::chrono::steady_clock::time_point origin;
+  bool first;
+
+  static double microseconds(std::chrono::steady_clock::duration duration)
+  {
+    return std::chrono::duration<double, std::micro>(duration).count();
+  }
+
+public:
+  explicit ChromeTraceWriter(std::ostream& out)
+    : out(out), origin(std::chrono::steady_clock::now()), first(true)
+  {
+    out << "{\"traceEvents\": [\n";
+  }
+
+  ~ChromeTraceWriter()
+  {
+    out << "\n]}\n";
+    out.flush();
+  }
+
+  ChromeTraceWriter(const ChromeTraceWriter&) = delete;
+  ChromeTraceWriter& operator=(const ChromeTraceWriter&) = delete;
+
+  // Formats into a stream of its own, so the caller's stream keeps its
+  // flags and precision, and the lock is held for one write only.
+  void operator()(const MapEvent& event)
+  {
+    std::uint64_t thread = std::hash<std::thread::id>()(std::this_thread::get_id()) & 0xffffffff;
+    std::ostringstream line;
+    line << std::fixed
+         << "{\"name\": \"" << event.map << "::" << MapEvent::kindName(event.kind)
+         << "\", \"cat\": \"aisdi\", \"ph\": \"X\", \"ts\": " << microseconds(event.start - origin)
+         << ", \"dur\": " << microseconds(event.duration) << ", \"pid\": 1, \"tid\": " << thread
+         << ", \"args\": {\"elements\": " << event.elements << ", \"instance\": \""
+         << event.instance << "\"}}";
+    std::lock_guard<std::mutex> lock(mutex);
+    out << (first ? "  " : ",\n  ") << line.str();
+    first = false;
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_EVENTHOOKS_H */
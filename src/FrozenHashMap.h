@@ -0,0 +1,302 @@
+#ifndef AISDI_MAPS_FROZENHASHMAP_H
+#define AISDI_MAPS_FROZENHASHMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <BucketPolicy.h>
+#include <HashMap.h>
+#include <PerfectHash.h>
+
+namespace aisdi
+{
+
+// Read-only map over a key set fixed at construction, for tables that are
+// built once and then only looked up. A minimal perfect hash, built by
+// hash-and-displace (CHD, PTHash), gives each key its own slot in one
+// contiguous array of exactly getSize() entries:
+//
+//   - a key's 64-bit hash picks one of about n / 5 groups;
+//   - each group has a pilot, searched for at construction, that is mixed
+//     into the hash so that all of the group's keys land in free slots of
+//     a table 1/32 larger than n (a full table makes the search for the
+//     last groups slow);
+//   - the few keys landing beyond n are moved to the slots left free.
+//
+// A lookup is one hash, a read from the small pilot array and one access
+// to the entry, whose key is compared so that keys outside the set are
+// rejected; one key in 33 also reads the remap array. The index costs
+// about 4.2 bits per key: 3.2 for the pilots, stored in 16 bits (the few
+// that need more are looked up in a side table), 1 for the remap array.
+// Construction takes around a microsecond per key. A later duplicate of
+// a key replaces the value of the earlier one, as with HashMap's
+// initializer list.
+template <typename KeyType, typename ValueType>
+class FrozenHashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  // entries are never modified, so the key needs no const
+  using value_type = std::pair<key_type, mapped_type>;
+  using size_type = std::size_t;
+  using const_reference = const value_type&;
+  using const_iterator = typename std::vector<value_type>::const_iterator;
+  using iterator = const_iterator;
+
+private:
+  static const std::size_t KEYS_PER_GROUP = 5;
+  // the hash spreads keys over n + n / SPARE slots
+  static const std::size_t SPARE = 32;
+  // seeds tried before giving up; each one fails with a tiny probability
+  static const unsigned int ATTEMPTS = 64;
+  // pilots from ESCAPE up are kept in largePilots
+  static const std::uint16_t ESCAPE = UINT16_MAX;
+
+  std::vector<value_type> entries;
+  std::vector<std::uint16_t> pilots;
+  // (group, pilot) of the rare groups whose pilot needs more than 16
+  // bits, by group
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> largePilots;
+  // where the keys hashed to slots n and above are stored
+  std::vector<std::uint32_t> remap;
+  std::uint64_t seed;
+
+  std::uint64_t hash(const key_type& key) const
+  {
+    return PerfectHash::mix(bucketHash(key) ^ seed);
+  }
+
+  void build(std::vector<value_type> input)
+  {
+    if (input.size() > UINT32_MAX)
+        throw std::length_error("FrozenHashMap: too many keys");
+    for (unsigned int attempt = 0; attempt < ATTEMPTS; attempt++)
+    {
+        seed = PerfectHash::seed(attempt);
+        if (tryBuild(input))
+            return;
+    }
+    throw std::runtime_error("FrozenHashMap: no perfect hash found");
+  }
+
+  // Fails when two distinct keys hash alike under the current seed or a
+  // group runs out of pilots; the input is moved from only on success.
+  bool tryBuild(std::vector<value_type>& input)
+  {
+    // (hash, input index) sorted: equal hashes side by side, in input
+    // order, so that duplicate keys can be dropped
+    std::vector<std::pair<std::uint64_t, std::size_t>> sorted(input.size());
+    for (std::size_t i = 0; i < input.size(); i++)
+        sorted[i] = std::make_pair(hash(input[i].first), i);
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<std::pair<std::uint64_t, std::size_t>> keys;
+    for (std::size_t pos = 0; pos < sorted.size(); pos++)
+    {
+        if (pos + 1 < sorted.size() && sorted[pos + 1].first == sorted[pos].first)
+        {
+            if (!(input[sorted[pos + 1].second].first == input[sorted[pos].second].first))
+                return false;
+            continue;
+        }
+        keys.push_back(sorted[pos]);
+    }
+
+    const std::size_t n = keys.size();
+    const std::size_t tableSize = n + n / SPARE;
+    const std::size_t groups = std::max<std::size_t>(1, (n + KEYS_PER_GROUP - 1) / KEYS_PER_GROUP);
+
+    // keys stored group by group (a counting sort), so that the pilot
+    // search reads each group's hashes contiguously
+    std::vector<std::size_t> groupStart(groups + 1, 0);
+    for (const auto& key : keys)
+        groupStart[PerfectHash::groupOf(key.first, groups) + 1]++;
+    std::partial_sum(groupStart.begin(), groupStart.end(), groupStart.begin());
+    std::vector<std::pair<std::uint64_t, std::size_t>> grouped(n);
+    std::vector<std::size_t> cursor(groupStart.begin(), groupStart.end() - 1);
+    for (const auto& key : keys)
+        grouped[cursor[PerfectHash::groupOf(key.first, groups)]++] = key;
+
+    // the largest groups go first, while most slots are still free
+    std::vector<std::size_t> byDescendingSize(groups);
+    std::iota(byDescendingSize.begin(), byDescendingSize.end(), 0);
+    std::stable_sort(byDescendingSize.begin(), byDescendingSize.end(),
+                     [&groupStart](std::size_t a, std::size_t b)
+    {
+        return groupStart[a + 1] - groupStart[a] > groupStart[b + 1] - groupStart[b];
+    });
+
+    const std::uint64_t maxPilot = std::min<std::uint64_t>(UINT32_MAX, std::max<std::uint64_t>(n * 64, 1 << 20));
+    std::vector<std::uint16_t> newPilots(groups, 0);
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> newLargePilots;
+    std::vector<bool> taken(tableSize, false);
+    std::vector<std::size_t> slots(n);
+    for (std::size_t group : byDescendingSize)
+    {
+        const std::size_t first = groupStart[group];
+        const std::size_t last = groupStart[group + 1];
+        if (first == last)
+            break;
+        std::uint32_t pilot = 0;
+        for (;; pilot++)
+        {
+            if (pilot == maxPilot)
+                return false;
+            std::size_t placed = first;
+            for (; placed < last; placed++)
+            {
+                slots[placed] = PerfectHash::slotOf(grouped[placed].first, pilot, tableSize);
+                if (taken[slots[placed]])
+                    break;
+                taken[slots[placed]] = true;
+            }
+            if (placed == last)
+                break;
+            while (placed-- > first)
+                taken[slots[placed]] = false;
+        }
+        if (pilot < ESCAPE)
+            newPilots[group] = static_cast<std::uint16_t>(pilot);
+        else
+        {
+            newPilots[group] = ESCAPE;
+            newLargePilots.push_back(std::make_pair(static_cast<std::uint32_t>(group), pilot));
+        }
+    }
+    std::sort(newLargePilots.begin(), newLargePilots.end());
+
+    // keys placed beyond n move to the slots below n left free
+    std::vector<std::uint32_t> newRemap(tableSize - n);
+    std::size_t freeSlot = 0;
+    for (std::size_t slot = n; slot < tableSize; slot++)
+        if (taken[slot])
+        {
+            while (taken[freeSlot])
+                freeSlot++;
+            newRemap[slot - n] = static_cast<std::uint32_t>(freeSlot++);
+        }
+    std::vector<std::size_t> bySlot(n);
+    for (std::size_t pos = 0; pos < n; pos++)
+        bySlot[slots[pos] < n ? slots[pos] : newRemap[slots[pos] - n]] = grouped[pos].second;
+    entries.clear();
+    entries.reserve(n);
+    for (std::size_t key : bySlot)
+        entries.push_back(std::move(input[key]));
+    pilots.swap(newPilots);
+    largePilots.swap(newLargePilots);
+    remap.swap(newRemap);
+    return true;
+  }
+
+  const value_type* lookup(const key_type& key) const
+  {
+    if (entries.empty())
+        return nullptr;
+    std::uint64_t h = hash(key);
+    std::size_t group = PerfectHash::groupOf(h, pilots.size());
+    std::uint32_t pilot = pilots[group];
+    if (pilot == ESCAPE)
+        pilot = std::lower_bound(largePilots.begin(), largePilots.end(),
+                                 std::make_pair(static_cast<std::uint32_t>(group), std::uint32_t(0)))->second;
+    std::size_t slot = PerfectHash::slotOf(h, pilot, entries.size() + remap.size());
+    if (slot >= entries.size())
+        slot = remap[slot - entries.size()];
+    const value_type& entry = entries[slot];
+    return entry.first == key ? &entry : nullptr;
+  }
+
+public:
+  FrozenHashMap() : seed(0)
+  {}
+
+  template <typename InputIt>
+  FrozenHashMap(InputIt first, InputIt last) : seed(0)
+  {
+    std::vector<value_type> input;
+    for (; first != last; ++first)
+        input.push_back(value_type((*first).first, (*first).second));
+    build(std::move(input));
+  }
+
+  FrozenHashMap(std::initializer_list<value_type> list)
+    : FrozenHashMap(list.begin(), list.end())
+  {}
+
+  template <typename Stats, typename Buckets>
+  explicit FrozenHashMap(const HashMap<KeyType, ValueType, Stats, Buckets>& map)
+    : FrozenHashMap(map.begin(), map.end())
+  {}
+
+  bool isEmpty() const
+  {
+    return entries.empty();
+  }
+
+  size_type getSize() const
+  {
+    return entries.size();
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    const value_type* entry = lookup(key);
+    if (!entry)
+        throw std::out_of_range("");
+    return entry->second;
+  }
+
+  // Non-throwing lookup: returns nullptr when the key is missing.
+  const mapped_type* tryGet(const key_type& key) const
+  {
+    const value_type* entry = lookup(key);
+    return entry ? &entry->second : nullptr;
+  }
+
+  bool contains(const key_type& key) const
+  {
+    return lookup(key) != nullptr;
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    const value_type* entry = lookup(key);
+    return entry ? entries.begin() + (entry - entries.data()) : entries.end();
+  }
+
+  // Bytes taken by the perfect hash on top of the entries themselves.
+  std::size_t indexBytes() const
+  {
+    return pilots.size() * sizeof(std::uint16_t)
+        + largePilots.size() * sizeof(std::pair<std::uint32_t, std::uint32_t>)
+        + remap.size() * sizeof(std::uint32_t) + sizeof(seed);
+  }
+
+  const_iterator begin() const
+  {
+    return entries.begin();
+  }
+
+  const_iterator end() const
+  {
+    return entries.end();
+  }
+
+  const_iterator cbegin() const
+  {
+    return begin();
+  }
+
+  const_iterator cend() const
+  {
+    return end();
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_FROZENHASHMAP_H */
@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "HashMap.h"
+
+// Runs a file of sample keys through the bucket function of a HashMap
+// with one of the bucket policies and reports how evenly they spread, so
+// that a bad combination of key scheme and hash shows up before it shows
+// up in latencies. Exits with status 2 when the spread is not plausibly
+// uniform.
+
+namespace
+{
+
+using Key = std::uint64_t;
+
+void printUsage(std::ostream& out, const char * program)
+{
+    out << "usage: " << program << " [--max-z=Z] [--buckets=POLICY] FILE\n"
+        << "  FILE              keys separated by whitespace, decimal or 0x hex;\n"
+        << "                    - reads standard input\n"
+        << "  --max-z=Z         fail when the chi-squared uniformity z-score of\n"
+        << "                    the bucket sizes exceeds Z (default 3)\n"
+        << "  --buckets=POLICY  mod50 (default), pow2, fastrange or prime: the\n"
+        << "                    bucket policies of the benchmark's hash,\n"
+        << "                    hash-pow2, hash-fastrange and hash-prime maps\n";
+}
+
+// The distinct keys of each bucket with the number of nodes a lookup of
+// each visits in the bucket's tree, and how many keys were read in all.
+// The keys are bucketed directly rather than inserted into a HashMap,
+// whose unbalanced bucket trees would take quadratic time on the sorted
+// ID files this tool is mostly run on.
+template <typename Buckets>
+struct Sample
+{
+    std::vector<std::map<Key, std::size_t>> buckets;
+    std::size_t read;
+
+    Sample() : buckets(Buckets::COUNT), read(0)
+    {}
+
+    // A key inserted into an unbalanced search tree becomes a child of
+    // the deeper of its in-order neighbours, so its depth follows from
+    // theirs without walking the tree.
+    void add(Key key)
+    {
+        std::map<Key, std::size_t>& bucket = buckets[Buckets::index(aisdi::bucketHash(key))];
+        auto next = bucket.lower_bound(key);
+        if (next != bucket.end() && next->first == key)
+            return;
+        std::size_t depth = next != bucket.end() ? next->second : 0;
+        if (next != bucket.begin())
+            depth = std::max(depth, std::prev(next)->second);
+        bucket.emplace_hint(next, key, depth + 1);
+    }
+
+    aisdi::BucketStats stats() const
+    {
+        std::vector<std::size_t> sizes;
+        double probes = 0.0;
+        for (const auto& bucket : buckets)
+        {
+            sizes.push_back(bucket.size());
+            for (const auto& entry : bucket)
+                probes += entry.second;
+        }
+        aisdi::BucketStats stats = aisdi::BucketStats::fromBucketSizes(sizes);
+        stats.observedProbeLength = stats.size ? probes / stats.size : 0.0;
+        return stats;
+    }
+};
+
+template <typename Buckets>
+void readKeys(std::istream& in, Sample<Buckets>& sample)
+{
+    std::string token;
+    while (in >> token)
+    {
+        char * end = nullptr;
+        errno = 0;
+        Key key = std::strtoull(token.c_str(), &end, 0);
+        if (end == token.c_str() || *end != '\0' || errno == ERANGE || token[0] == '-')
+            throw std::invalid_argument("not a key: " + token);
+        sample.add(key);
+        sample.read++;
+    }
+}
+
+// Bucket sizes from the smallest to the largest in at most ten ranges of
+// equal width, one bar each.
+void printHistogram(std::ostream& out, const aisdi::BucketStats& stats)
+{
+    std::size_t smallest = 0;
+    while (stats.sizeHistogram[smallest] == 0)
+        smallest++;
+    const std::size_t sizes = stats.sizeHistogram.size() - smallest;
+    const std::size_t width = (sizes + 9) / 10;
+    for (std::size_t first = smallest; first < stats.sizeHistogram.size(); first += width)
+    {
+        std::size_t last = std::min(first + width, stats.sizeHistogram.size()) - 1;
+        std::size_t buckets = 0;
+        for (std::size_t size = first; size <= last; size++)
+            buckets += stats.sizeHistogram[size];
+        std::ostringstream range;
+        range << first;
+        if (last != first)
+            range << '-' << last;
+        out << std::setw(13) << range.str() << std::setw(10) << buckets << "  "
+            << std::string(buckets * 50 / stats.buckets, '#') << "\n";
+    }
+}
+
+// Returns whether the spread failed the uniformity check.
+template <typename Buckets>
+bool printReport(std::ostream& out, const Sample<Buckets>& sample, double maxZ)
+{
+    const aisdi::BucketStats stats = sample.stats();
+    const double z = stats.uniformityZ();
+    out << std::left << std::fixed << std::setprecision(1)
+        << std::setw(20) << "keys" << stats.size << " (" << sample.read - stats.size
+        << " duplicates skipped)\n"
+        << std::setw(20) << "buckets" << stats.buckets << "\n"
+        << std::setw(20) << "load factor" << stats.loadFactor << "\n"
+        << std::setw(20) << "occupied buckets" << stats.occupiedBuckets << " ("
+        << stats.occupiedRatio * 100.0 << "%)\n"
+        << std::setw(20) << "longest bucket" << stats.longestBucket << "\n"
+        << std::setw(20) << "probe length" << "expected " << stats.expectedProbeLength
+        << ", observed " << stats.observedProbeLength << "\n"
+        << std::setw(20) << "chi-squared" << stats.chiSquared() << " (" << stats.buckets - 1
+        << " degrees of freedom)\n"
+        << std::setw(20) << "uniformity z" << z << ": "
+        << (z > maxZ ? "NOT UNIFORM" : z < -maxZ ? "more even than random" : "plausibly uniform")
+        << "\n" << std::right << "bucket size     buckets\n";
+    printHistogram(out, stats);
+    return z > maxZ;
+}
+
+// The exit status: 0, 1 when the keys cannot be read, 2 when they are not
+// spread uniformly.
+template <typename Buckets>
+int analyze(const std::string& path, double maxZ)
+{
+    Sample<Buckets> sample;
+    try
+    {
+        if (path == "-")
+            readKeys(std::cin, sample);
+        else
+        {
+            std::ifstream file(path);
+            if (!file)
+                throw std::invalid_argument("cannot read " + path);
+            readKeys(file, sample);
+        }
+    }
+    catch (const std::invalid_argument& error)
+    {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+
+    return printReport(std::cout, sample, maxZ) ? 2 : 0;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    double maxZ = 3.0;
+    std::string buckets = "mod50";
+    std::string path;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument(argv[i]);
+        if (argument == "--help")
+        {
+            printUsage(std::cout, argv[0]);
+            return 0;
+        }
+        if (argument.compare(0, 8, "--max-z=") == 0)
+            maxZ = std::strtod(argument.c_str() + 8, nullptr);
+        else if (argument.compare(0, 10, "--buckets=") == 0)
+            buckets = argument.substr(10);
+        else if (path.empty())
+            path = argument;
+        else
+        {
+            printUsage(std::cerr, argv[0]);
+            return 1;
+        }
+    }
+    if (path.empty())
+    {
+        printUsage(std::cerr, argv[0]);
+        return 1;
+    }
+
+    if (buckets == "mod50")
+        return analyze<aisdi::ModuloBuckets<50>>(path, maxZ);
+    if (buckets == "pow2")
+        return analyze<aisdi::PowerOfTwoBuckets<64>>(path, maxZ);
+    if (buckets == "fastrange")
+        return analyze<aisdi::FastRangeBuckets<50>>(path, maxZ);
+    if (buckets == "prime")
+        return analyze<aisdi::PrimeBuckets<53>>(path, maxZ);
+    std::cerr << "unknown bucket policy: " << buckets << std::endl;
+    return 1;
+}
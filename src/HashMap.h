@@ -1,27 +1,124 @@
 #ifndef AISDI_MAPS_HASHMAP_H
 #define AISDI_MAPS_HASHMAP_H
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <initializer_list>
 #include <stdexcept>
 #include <utility>
 #include <vector>
+#include <BucketPolicy.h>
+#include <EventHooks.h>
 #include <TreeMap.h>
 
 namespace aisdi
 {
 
-template <typename KeyType, typename ValueType>
+// How evenly the keys of a HashMap are spread over its buckets, see
+// HashMap::bucketStats().
+struct BucketStats
+{
+  std::size_t size;
+  std::size_t buckets;
+  // entries per bucket
+  double loadFactor;
+  std::size_t occupiedBuckets;
+  double occupiedRatio;
+  // number of buckets holding k entries, for k = 0..longestBucket
+  std::vector<std::size_t> sizeHistogram;
+  std::size_t longestBucket;
+  // Nodes a successful lookup visits in its bucket tree, on average: as
+  // expected if the keys were spread evenly and every bucket were a
+  // randomly built tree, and as found.
+  double expectedProbeLength;
+  double observedProbeLength;
+
+  // Pearson's chi-squared of the bucket sizes against an even spread,
+  // with buckets - 1 degrees of freedom.
+  double chiSquared() const
+  {
+    if (size==0)
+        return 0.0;
+    double expected=static_cast<double>(size)/buckets;
+    double sum=0.0;
+    for (std::size_t k=0;k<sizeHistogram.size();k++)
+        sum+=sizeHistogram[k]*(k-expected)*(k-expected)/expected;
+    return sum;
+  }
+
+  // chiSquared() as a standard normal deviate (Wilson-Hilferty). Above 3
+  // the spread is very unlikely to come from a uniform hash; well below
+  // -3 it is suspiciously even (e.g. sequential keys).
+  double uniformityZ() const
+  {
+    if (buckets<2 || size==0)
+        return 0.0;
+    double degrees=buckets-1.0;
+    double variance=2.0/(9.0*degrees);
+    return (std::cbrt(chiSquared()/degrees)-(1.0-variance))/std::sqrt(variance);
+  }
+
+  // Everything but observedProbeLength, from the number of entries in
+  // each bucket.
+  static BucketStats fromBucketSizes(const std::vector<std::size_t>& bucketSizes)
+  {
+    BucketStats stats;
+    stats.size=0;
+    stats.buckets=bucketSizes.size();
+    stats.occupiedBuckets=0;
+    stats.longestBucket=0;
+    for (std::size_t bucketSize : bucketSizes)
+    {
+        if (bucketSize>=stats.sizeHistogram.size())
+            stats.sizeHistogram.resize(bucketSize+1, 0);
+        stats.sizeHistogram[bucketSize]++;
+        if (bucketSize>0)
+            stats.occupiedBuckets++;
+        stats.longestBucket=std::max(stats.longestBucket, bucketSize);
+        stats.size+=bucketSize;
+    }
+    stats.loadFactor=static_cast<double>(stats.size)/stats.buckets;
+    stats.occupiedRatio=static_cast<double>(stats.occupiedBuckets)/stats.buckets;
+    // even spread: size % buckets buckets get one key more than the rest
+    std::size_t smaller=stats.size/stats.buckets;
+    std::size_t larger=stats.size%stats.buckets;
+    stats.expectedProbeLength=stats.size ? (larger*(smaller+1)*randomTreeProbeLength(smaller+1)
+        +(stats.buckets-larger)*smaller*randomTreeProbeLength(smaller))/stats.size : 0.0;
+    stats.observedProbeLength=0.0;
+    return stats;
+  }
+
+  // Average nodes visited by a successful search in a randomly built
+  // binary search tree of n nodes: 2(1 + 1/n)H(n) - 3 (Knuth, 6.2.2).
+  static double randomTreeProbeLength(std::size_t n)
+  {
+    if (n==0)
+        return 0.0;
+    double harmonic=0.0;
+    for (std::size_t i=1;i<=n;i++)
+        harmonic+=1.0/i;
+    return 2.0*(1.0+1.0/n)*harmonic-3.0;
+  }
+};
+
+// Stats is a statistics policy from StatsPolicy.h, kept per bucket;
+// Buckets a bucket policy from BucketPolicy.h.
+template <typename KeyType, typename ValueType, typename Stats = NoStats,
+          typename Buckets = ModuloBuckets<50>>
 class HashMap
 {
 private:
-  std::vector<TreeMap<KeyType,ValueType>> wektor;
+  using Bucket = TreeMap<KeyType, ValueType, Stats>;
+
+  std::vector<Bucket> wektor;
   size_t size;
-  const unsigned int BUCKETS=50;
+  static constexpr unsigned int BUCKETS=Buckets::COUNT;
+  static const unsigned int BATCH=64;
 
-  int h(const KeyType key) const
+  unsigned int h(const KeyType& key) const
   {
-    return key%BUCKETS;
+    return Buckets::index(bucketHash(key));
   }
 
 public:
@@ -48,8 +145,8 @@ public:
 
   ~HashMap()
   {
-    while(size>0)
-        remove(begin());
+    MapEvents::Scope event(MapEvent::Destroy, "HashMap", this, size);
+    clear();
   }
 
   HashMap(std::initializer_list<value_type> list)
@@ -63,6 +160,7 @@ public:
 
   HashMap(const HashMap& other)
   {
+    MapEvents::Scope event(MapEvent::Copy, "HashMap", this, other.size);
     size=other.size;
     wektor=other.wektor;
   }
@@ -70,7 +168,7 @@ public:
   HashMap(HashMap&& other)
   {
     size=other.size;
-    wektor=other.wektor;
+    wektor=std::move(other.wektor);
     other.size=0;
     other.wektor.clear();
     other.wektor.reserve(BUCKETS);
@@ -79,10 +177,10 @@ public:
 
   HashMap& operator=(const HashMap& other)
   {
-    if (*this==other)
+    if (this==&other)
         return *this;
-    while(size>0)
-        remove(begin());
+    MapEvents::Scope event(MapEvent::Copy, "HashMap", this, size+other.size);
+    clear();
     wektor=other.wektor;
     size=other.size;
     return *this;
@@ -90,10 +188,11 @@ public:
 
   HashMap& operator=(HashMap&& other)
   {
-    if (*this==other)
+    if (this==&other)
         return *this;
+    clear();
     size=other.size;
-    wektor=other.wektor;
+    wektor=std::move(other.wektor);
     other.size=0;
     other.wektor.clear();
     other.wektor.reserve(BUCKETS);
@@ -108,32 +207,109 @@ public:
     return false;
   }
 
-  mapped_type& operator[](const key_type& key)
+  // Releases every bucket's nodes in a single sweep over the bucket array,
+  // instead of repeatedly locating and removing begin().
+  void clear()
+  {
+    MapEvents::Scope event(MapEvent::Clear, "HashMap", this, size);
+    for (auto& bucket : wektor)
+        bucket.clear();
+    size=0;
+  }
+
+  // Hashes the key once and descends its bucket once, inserting a
+  // default-constructed value if the key is missing.
+  std::pair<iterator, bool> insertOrGet(const key_type& key)
   {
-    if (find(h(key))==end())
+    unsigned int index=h(key);
+    auto result=wektor[index].insertOrGet(key);
+    if (result.second)
         size++;
-    return wektor[h(key)].operator[](key);
+    Iterator iter;
+    iter.hashmap=this;
+    iter.index=index;
+    iter.treeiter=result.first;
+    return std::make_pair(iter, result.second);
+  }
+
+  mapped_type& operator[](const key_type& key)
+  {
+    return insertOrGet(key).first->second;
   }
 
   const mapped_type& valueOf(const key_type& key) const
   {
-    if (isEmpty())
-        throw std::out_of_range("");
     return wektor[h(key)].valueOf(key);
   }
 
   mapped_type& valueOf(const key_type& key)
   {
-    if (isEmpty())
-        throw std::out_of_range("");
     return wektor[h(key)].valueOf(key);
   }
 
+  // Non-throwing lookup: returns nullptr when the key is missing.
+  const mapped_type* tryGet(const key_type& key) const
+  {
+    return wektor[h(key)].tryGet(key);
+  }
+
+  mapped_type* tryGet(const key_type& key)
+  {
+    return wektor[h(key)].tryGet(key);
+  }
+
+  bool contains(const key_type& key) const
+  {
+    return wektor[h(key)].contains(key);
+  }
+
+  // Looks up every key in [keysBegin, keysEnd) and writes a pointer to its
+  // value (nullptr on a miss) to out. Keys are handled in groups: all of a
+  // group's buckets are hashed first, then the descents into the bucket
+  // trees run interleaved (TreeMap::findInterleaved), so the cache misses
+  // of a group overlap instead of being paid one after another.
+  // Needs forward iterators: keys are referenced, not copied.
+  template <typename ForwardIt, typename OutputIt>
+  OutputIt findMany(ForwardIt keysBegin, ForwardIt keysEnd, OutputIt out) const
+  {
+    const Bucket * trees[BATCH];
+    const KeyType * keys[BATCH];
+    const ValueType * results[BATCH];
+    while (keysBegin!=keysEnd)
+    {
+        unsigned int count=0;
+        for (;keysBegin!=keysEnd && count<BATCH;++keysBegin, ++count)
+        {
+            keys[count]=&*keysBegin;
+            trees[count]=&wektor[h(*keysBegin)];
+        }
+        Bucket::findInterleaved(trees, keys, results, count);
+        for (unsigned int i=0;i<count;i++)
+            *out++=results[i];
+    }
+    return out;
+  }
+
+  // Like findMany, but writes whether each key is present.
+  template <typename ForwardIt, typename OutputIt>
+  OutputIt containsMany(ForwardIt keysBegin, ForwardIt keysEnd, OutputIt out) const
+  {
+    const mapped_type* found[BATCH];
+    while (keysBegin!=keysEnd)
+    {
+        ForwardIt groupEnd=keysBegin;
+        for (unsigned int count=0; groupEnd!=keysEnd && count<BATCH; ++groupEnd, ++count);
+        const mapped_type** last=findMany(keysBegin, groupEnd, found);
+        for (const mapped_type** value=found; value!=last; ++value)
+            *out++=(*value!=nullptr);
+        keysBegin=groupEnd;
+    }
+    return out;
+  }
+
   const_iterator find(const key_type& key) const
   {
-    if (isEmpty())
-        return end();
-    typename TreeMap<KeyType, ValueType>::ConstIterator treeiter=wektor[h(key)].find(key);
+    typename Bucket::ConstIterator treeiter=wektor[h(key)].find(key);
     if (treeiter==wektor[h(key)].end())
         return end();
     ConstIterator iter;
@@ -145,9 +321,7 @@ public:
 
   iterator find(const key_type& key)
   {
-    if (isEmpty())
-        return end();
-    typename TreeMap<KeyType, ValueType>::ConstIterator treeiter=wektor[h(key)].find(key);
+    typename Bucket::ConstIterator treeiter=wektor[h(key)].find(key);
     if (treeiter==wektor[h(key)].end())
         return end();
     Iterator iter;
@@ -173,6 +347,49 @@ public:
     return size;
   }
 
+  // Sum of the buckets' counters; all zero unless Stats counts them.
+  MapCounters counters() const
+  {
+    MapCounters total = MapCounters();
+    for (const auto& bucket : wektor)
+        total+=bucket.counters();
+    return total;
+  }
+
+  void resetCounters()
+  {
+    for (auto& bucket : wektor)
+        bucket.resetCounters();
+  }
+
+  static constexpr unsigned int bucketCount()
+  {
+    return BUCKETS;
+  }
+
+  // Bucket the key hashes to, in [0, bucketCount()).
+  unsigned int bucketOf(const key_type& key) const
+  {
+    return h(key);
+  }
+
+  // Walks every bucket once: O(n).
+  BucketStats bucketStats() const
+  {
+    std::vector<std::size_t> bucketSizes;
+    bucketSizes.reserve(BUCKETS);
+    double probes=0.0;
+    for (const auto& bucket : wektor)
+    {
+        TreeStats tree=bucket.stats();
+        bucketSizes.push_back(tree.size);
+        probes+=tree.size*(tree.averageDepth+1.0);
+    }
+    BucketStats stats=BucketStats::fromBucketSizes(bucketSizes);
+    stats.observedProbeLength=size ? probes/size : 0.0;
+    return stats;
+  }
+
   bool operator==(const HashMap& other) const
   {
     if (this->size != other.size)
@@ -200,16 +417,17 @@ public:
     iter.hashmap=this;
     if (isEmpty())
     {
-        iter.index=BUCKETS;
+        iter.index=BUCKETS-1;
         iter.treeiter=wektor[BUCKETS-1].end();
         return iter;
     }
-    for (int i=0;i<BUCKETS;i++)
+    for (unsigned int i=0;i<BUCKETS;i++)
     {
         if (!wektor[i].isEmpty())
         {
             iter.index=i;
             iter.treeiter=wektor[i].begin();
+            break;
         }
     }
     return iter;
@@ -234,12 +452,13 @@ public:
         iter.treeiter=wektor[BUCKETS-1].end();
         return iter;
     }
-    for (int i=0;i<BUCKETS;i++)
+    for (unsigned int i=0;i<BUCKETS;i++)
     {
         if (!wektor[i].isEmpty())
         {
             iter.index=i;
             iter.treeiter=wektor[i].begin();
+            break;
         }
     }
     return iter;
@@ -265,13 +484,16 @@ public:
   }
 };
 
-template <typename KeyType, typename ValueType>
-class HashMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename Stats, typename Buckets>
+constexpr unsigned int HashMap<KeyType, ValueType, Stats, Buckets>::BUCKETS;
+
+template <typename KeyType, typename ValueType, typename Stats, typename Buckets>
+class HashMap<KeyType, ValueType, Stats, Buckets>::ConstIterator
 {
 protected:
   const HashMap * hashmap;
   unsigned int index;
-  typename TreeMap<KeyType, ValueType>::ConstIterator treeiter;
+  typename Bucket::ConstIterator treeiter;
 
 public:
   using reference = typename HashMap::const_reference;
@@ -291,9 +513,17 @@ public:
     treeiter=other.treeiter;
   }
 
+  ConstIterator& operator=(const ConstIterator& other)
+  {
+    hashmap=other.hashmap;
+    index=other.index;
+    treeiter=other.treeiter;
+    return *this;
+  }
+
   ConstIterator& operator++()
   {
-    if (!((++treeiter)==hashmap->wektor[index].end()))
+    if ((++treeiter)==hashmap->wektor[index].end())
     {
         for (index++;index<hashmap->BUCKETS;index++)
         {
@@ -327,8 +557,9 @@ public:
     else
     {
 
-        for (index--;index>=0;index--)
+        while (index>0)
         {
+            index--;
             if (!(hashmap->wektor[index].isEmpty()))
             {
                 treeiter=(hashmap->wektor[index].end());
@@ -372,8 +603,9 @@ public:
   }
 };
 
-template <typename KeyType, typename ValueType>
-class HashMap<KeyType, ValueType>::Iterator : public HashMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename Stats, typename Buckets>
+class HashMap<KeyType, ValueType, Stats, Buckets>::Iterator
+  : public HashMap<KeyType, ValueType, Stats, Buckets>::ConstIterator
 {
 public:
   using reference = typename HashMap::reference;
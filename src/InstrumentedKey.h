@@ -0,0 +1,115 @@
+#ifndef AISDI_MAPS_INSTRUMENTEDKEY_H
+#define AISDI_MAPS_INSTRUMENTEDKEY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <TreeMap.h>
+
+namespace aisdi
+{
+
+// What the maps did with InstrumentedKey keys: key comparisons (<, >, ==,
+// !=), hash computations (HashMap's bucketHash() or std::hash) and tree
+// nodes stepped on by key searches. Plain counters, so only meaningful
+// for maps used by a single thread.
+struct KeyCounters
+{
+  std::uint64_t comparisons;
+  std::uint64_t hashes;
+  std::uint64_t visits;
+
+  KeyCounters operator-(const KeyCounters& other) const
+  {
+    KeyCounters result = { comparisons - other.comparisons, hashes - other.hashes,
+                           visits - other.visits };
+    return result;
+  }
+};
+
+// Totals since program start, shared by every InstrumentedKey type;
+// callers take the difference of two readings.
+inline KeyCounters& keyCounters()
+{
+  static KeyCounters counters = { 0, 0, 0 };
+  return counters;
+}
+
+// Key wrapper that counts every comparison and hash of it, so that the
+// work a map does per operation can be measured exactly, free of timer
+// noise. Converts implicitly from Key: maps over plain keys switch to it
+// by changing the key type only.
+template <typename Key>
+class InstrumentedKey
+{
+private:
+  Key key;
+
+public:
+  InstrumentedKey(const Key& key = Key()) : key(key)
+  {}
+
+  const Key& get() const
+  {
+    return key;
+  }
+
+  friend bool operator==(const InstrumentedKey& a, const InstrumentedKey& b)
+  {
+    keyCounters().comparisons++;
+    return a.key == b.key;
+  }
+
+  friend bool operator!=(const InstrumentedKey& a, const InstrumentedKey& b)
+  {
+    keyCounters().comparisons++;
+    return a.key != b.key;
+  }
+
+  friend bool operator<(const InstrumentedKey& a, const InstrumentedKey& b)
+  {
+    keyCounters().comparisons++;
+    return a.key < b.key;
+  }
+
+  friend bool operator>(const InstrumentedKey& a, const InstrumentedKey& b)
+  {
+    keyCounters().comparisons++;
+    return a.key > b.key;
+  }
+
+  // what HashMap buckets the key by
+  friend std::uint64_t bucketHash(const InstrumentedKey& key)
+  {
+    keyCounters().hashes++;
+    return static_cast<std::uint64_t>(key.key);
+  }
+};
+
+template <typename Key>
+struct NodeVisits<InstrumentedKey<Key>>
+{
+  static void count()
+  {
+    keyCounters().visits++;
+  }
+};
+
+}
+
+namespace std
+{
+
+template <typename Key>
+struct hash<aisdi::InstrumentedKey<Key>>
+{
+  std::size_t operator()(const aisdi::InstrumentedKey<Key>& key) const
+  {
+    aisdi::keyCounters().hashes++;
+    return std::hash<Key>()(key.get());
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_INSTRUMENTEDKEY_H */
@@ -0,0 +1,149 @@
+#ifndef AISDI_MAPS_LATENCYHISTOGRAM_H
+#define AISDI_MAPS_LATENCYHISTOGRAM_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+
+namespace aisdi
+{
+
+// Histogram of non-negative integer latencies (nanoseconds, ticks, ...)
+// laid out like HdrHistogram: values below SUB_BUCKETS get a bucket each,
+// every higher power-of-two range is split into SUB_BUCKETS equal buckets.
+// A value is therefore reported at most 1/SUB_BUCKETS (about 3%) too high,
+// over the whole 64-bit range. Memory is fixed (15 KiB) and record() does
+// not allocate, so it can sit on a hot path.
+class LatencyHistogram
+{
+public:
+  static const unsigned int SUB_BITS = 5;
+  static const std::uint64_t SUB_BUCKETS = std::uint64_t(1) << SUB_BITS;
+  static const std::size_t BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+private:
+  std::uint64_t counts[BUCKETS];
+  std::uint64_t total;
+  std::uint64_t minimum;
+  std::uint64_t maximum;
+
+  static unsigned int highestBit(std::uint64_t value)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    unsigned int bit = 0;
+    while (value >>= 1)
+        bit++;
+    return bit;
+#endif
+  }
+
+public:
+  LatencyHistogram()
+  {
+    reset();
+  }
+
+  static std::size_t bucketOf(std::uint64_t value)
+  {
+    if (value < SUB_BUCKETS)
+        return value;
+    unsigned int shift = highestBit(value) - SUB_BITS;
+    return (shift + 1) * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS);
+  }
+
+  // Largest value that falls into bucket.
+  static std::uint64_t highestIn(std::size_t bucket)
+  {
+    if (bucket < SUB_BUCKETS)
+        return bucket;
+    unsigned int shift = bucket / SUB_BUCKETS - 1;
+    std::uint64_t lowest = (bucket % SUB_BUCKETS + SUB_BUCKETS) << shift;
+    return lowest + ((std::uint64_t(1) << shift) - 1);
+  }
+
+  void record(std::uint64_t value, std::uint64_t count = 1)
+  {
+    counts[bucketOf(value)] += count;
+    total += count;
+    if (value < minimum)
+        minimum = value;
+    if (value > maximum)
+        maximum = value;
+  }
+
+  void merge(const LatencyHistogram& other)
+  {
+    for (std::size_t i = 0; i < BUCKETS; i++)
+        counts[i] += other.counts[i];
+    total += other.total;
+    if (other.minimum < minimum)
+        minimum = other.minimum;
+    if (other.maximum > maximum)
+        maximum = other.maximum;
+  }
+
+  void reset()
+  {
+    for (std::size_t i = 0; i < BUCKETS; i++)
+        counts[i] = 0;
+    total = 0;
+    minimum = UINT64_MAX;
+    maximum = 0;
+  }
+
+  std::uint64_t getCount() const
+  {
+    return total;
+  }
+
+  std::uint64_t getMin() const
+  {
+    return total ? minimum : 0;
+  }
+
+  std::uint64_t getMax() const
+  {
+    return maximum;
+  }
+
+  // Smallest bucket bound that at least q (in [0, 1]) of the recorded
+  // values do not exceed; never more than the largest recorded value.
+  std::uint64_t percentile(double q) const
+  {
+    if (total == 0)
+        return 0;
+    std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(q * total));
+    if (rank == 0)
+        rank = 1;
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < BUCKETS; i++)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+            return highestIn(i) < maximum ? highestIn(i) : maximum;
+    }
+    return maximum;
+  }
+
+  // One line: count p50 p90 p99 p99.9 max.
+  void print(std::ostream& out) const
+  {
+    out << std::setw(10) << total << std::setw(10) << percentile(0.5)
+        << std::setw(10) << percentile(0.9) << std::setw(10) << percentile(0.99)
+        << std::setw(10) << percentile(0.999) << std::setw(10) << getMax();
+  }
+
+  static void printHeader(std::ostream& out)
+  {
+    out << std::setw(10) << "count" << std::setw(10) << "p50" << std::setw(10) << "p90"
+        << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(10) << "max";
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_LATENCYHISTOGRAM_H */
@@ -0,0 +1,233 @@
+#ifndef AISDI_MAPS_LATENCYTRACKED_H
+#define AISDI_MAPS_LATENCYTRACKED_H
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <ostream>
+#include <utility>
+#include <LatencyHistogram.h>
+
+namespace aisdi
+{
+
+// Opt-in latency tracking for TreeMap and HashMap: wraps a map and records
+// how long every operation took, in nanoseconds, in a histogram per
+// operation type. Maps that are not wrapped pay nothing.
+//   LatencyTracked<HashMap<int, std::string>> map;
+//   ... use map like the HashMap ...
+//   map.printLatencies(std::cerr);
+// A steady_clock read costs some 20 ns, so very fast operations are
+// reported higher than they are; the tail is what this is for.
+template <typename Map>
+class LatencyTracked
+{
+public:
+  using map_type = Map;
+  using key_type = typename Map::key_type;
+  using mapped_type = typename Map::mapped_type;
+  using value_type = typename Map::value_type;
+  using size_type = typename Map::size_type;
+  using iterator = typename Map::iterator;
+  using const_iterator = typename Map::const_iterator;
+
+  enum Operation
+  {
+    Index,     // operator[] and insertOrGet
+    Find,      // find, tryGet, contains, valueOf
+    Remove,
+    Begin,     // begin, cbegin (HashMap scans for the first bucket)
+    OPERATIONS
+  };
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  Map map;
+  mutable LatencyHistogram histograms[OPERATIONS];
+
+  class Timer
+  {
+  private:
+    LatencyHistogram& histogram;
+    Clock::time_point start;
+
+  public:
+    explicit Timer(LatencyHistogram& histogram) : histogram(histogram), start(Clock::now())
+    {}
+
+    ~Timer()
+    {
+      histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now() - start).count());
+    }
+  };
+
+public:
+  LatencyTracked()
+  {}
+
+  explicit LatencyTracked(Map map) : map(std::move(map))
+  {}
+
+  static const char * operationName(Operation operation)
+  {
+    static const char * const names[OPERATIONS] = { "index", "find", "remove", "begin" };
+    return names[operation];
+  }
+
+  mapped_type& operator[](const key_type& key)
+  {
+    Timer timer(histograms[Index]);
+    return map[key];
+  }
+
+  std::pair<iterator, bool> insertOrGet(const key_type& key)
+  {
+    Timer timer(histograms[Index]);
+    return map.insertOrGet(key);
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    Timer timer(histograms[Find]);
+    return map.valueOf(key);
+  }
+
+  mapped_type& valueOf(const key_type& key)
+  {
+    Timer timer(histograms[Find]);
+    return map.valueOf(key);
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    Timer timer(histograms[Find]);
+    return map.find(key);
+  }
+
+  iterator find(const key_type& key)
+  {
+    Timer timer(histograms[Find]);
+    return map.find(key);
+  }
+
+  const mapped_type * tryGet(const key_type& key) const
+  {
+    Timer timer(histograms[Find]);
+    return map.tryGet(key);
+  }
+
+  mapped_type * tryGet(const key_type& key)
+  {
+    Timer timer(histograms[Find]);
+    return map.tryGet(key);
+  }
+
+  bool contains(const key_type& key) const
+  {
+    Timer timer(histograms[Find]);
+    return map.contains(key);
+  }
+
+  void remove(const key_type& key)
+  {
+    Timer timer(histograms[Remove]);
+    map.remove(key);
+  }
+
+  void remove(const const_iterator& it)
+  {
+    Timer timer(histograms[Remove]);
+    map.remove(it);
+  }
+
+  iterator begin()
+  {
+    Timer timer(histograms[Begin]);
+    return map.begin();
+  }
+
+  const_iterator begin() const
+  {
+    Timer timer(histograms[Begin]);
+    return map.begin();
+  }
+
+  const_iterator cbegin() const
+  {
+    return begin();
+  }
+
+  iterator end()
+  {
+    return map.end();
+  }
+
+  const_iterator end() const
+  {
+    return map.end();
+  }
+
+  const_iterator cend() const
+  {
+    return map.cend();
+  }
+
+  size_type getSize() const
+  {
+    return map.getSize();
+  }
+
+  bool isEmpty() const
+  {
+    return map.isEmpty();
+  }
+
+  void clear()
+  {
+    map.clear();
+  }
+
+  // The wrapped map; operations made directly on it are not recorded.
+  Map& underlying()
+  {
+    return map;
+  }
+
+  const Map& underlying() const
+  {
+    return map;
+  }
+
+  const LatencyHistogram& latency(Operation operation) const
+  {
+    return histograms[operation];
+  }
+
+  void resetLatencies()
+  {
+    for (std::size_t i = 0; i < OPERATIONS; i++)
+        histograms[i].reset();
+  }
+
+  // Table of p50/p90/p99/p99.9/max in ns for every operation used so far.
+  void printLatencies(std::ostream& out) const
+  {
+    out << std::left << std::setw(8) << "op" << std::right;
+    LatencyHistogram::printHeader(out);
+    out << "\n";
+    for (std::size_t i = 0; i < OPERATIONS; i++)
+    {
+        if (histograms[i].getCount() == 0)
+            continue;
+        out << std::left << std::setw(8) << operationName(static_cast<Operation>(i)) << std::right;
+        histograms[i].print(out);
+        out << "\n";
+    }
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_LATENCYTRACKED_H */
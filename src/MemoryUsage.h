@@ -0,0 +1,77 @@
+#ifndef AISDI_MAPS_MEMORYUSAGE_H
+#define AISDI_MAPS_MEMORYUSAGE_H
+
+#include <cstddef>
+#include <fstream>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace aisdi
+{
+namespace benchmark
+{
+
+// Resident set size of the process in bytes, from /proc/self/statm;
+// 0 where that is not available.
+inline std::size_t residentBytes()
+{
+#if defined(__linux__)
+  std::ifstream statm("/proc/self/statm");
+  std::size_t size = 0;
+  std::size_t resident = 0;
+  if (statm >> size >> resident)
+    return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+  return 0;
+}
+
+// What malloc itself reports. inUse counts every block handed out
+// including malloc's headers and rounding; reserved is everything taken
+// from the OS (main arena plus mmapped blocks). reserved - inUse is memory
+// the allocator holds but cannot give back: free holes, i.e. fragmentation.
+// Both are 0 outside glibc.
+struct HeapUsage
+{
+  std::size_t inUse;
+  std::size_t reserved;
+
+  double fragmentation() const
+  {
+    return reserved ? static_cast<double>(reserved - inUse) / reserved : 0.0;
+  }
+};
+
+inline HeapUsage heapUsage()
+{
+  HeapUsage usage = { 0, 0 };
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  struct mallinfo2 info = mallinfo2();
+  usage.inUse = info.uordblks + info.hblkhd;
+  usage.reserved = info.arena + info.hblkhd;
+#elif defined(__GLIBC__)
+  // older glibc only has the int fields, which wrap past 2 GiB
+  struct mallinfo info = mallinfo();
+  usage.inUse = static_cast<unsigned int>(info.uordblks) + static_cast<unsigned int>(info.hblkhd);
+  usage.reserved = static_cast<unsigned int>(info.arena) + static_cast<unsigned int>(info.hblkhd);
+#endif
+  return usage;
+}
+
+// Hands free memory at the top of the heap back to the OS, so that one
+// benchmark run starts less affected by the previous one.
+inline void releaseFreeMemory()
+{
+#if defined(__GLIBC__)
+  malloc_trim(0);
+#endif
+}
+
+}
+}
+
+#endif /* AISDI_MAPS_MEMORYUSAGE_H */
@@ -0,0 +1,169 @@
+#ifndef AISDI_MAPS_PERFCOUNTERS_H
+#define AISDI_MAPS_PERFCOUNTERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace aisdi
+{
+namespace benchmark
+{
+
+// Hardware event counters of the calling thread, via Linux perf_event_open.
+// Every event is opened on its own, so a CPU or VM that lacks one of them
+// loses just that column. Containers often forbid perf_event_open
+// altogether (seccomp, perf_event_paranoid); then nothing is available and
+// the benchmark reports times only. Elsewhere than on Linux the counters
+// are never available.
+// The counters run from construction on; callers take the difference of
+// two read()s. User-space events only, scaled up when the kernel had to
+// multiplex them.
+class PerfCounters
+{
+public:
+  enum Event
+  {
+    Cycles,
+    Instructions,
+    L1dMisses,
+    LlcMisses,
+    BranchMisses,
+    DtlbMisses,
+    EVENTS
+  };
+
+  struct Reading
+  {
+    double values[EVENTS];
+
+    Reading()
+    {
+      for (std::size_t i = 0; i < EVENTS; i++)
+          values[i] = 0.0;
+    }
+
+    Reading operator-(const Reading& other) const
+    {
+      Reading result;
+      for (std::size_t i = 0; i < EVENTS; i++)
+          result.values[i] = values[i] - other.values[i];
+      return result;
+    }
+  };
+
+private:
+  int fds[EVENTS];
+
+#ifdef __linux__
+  static int open(std::uint32_t type, std::uint64_t config)
+  {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+
+  static std::uint64_t cacheMiss(std::uint64_t cache)
+  {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  }
+#endif
+
+public:
+  PerfCounters()
+  {
+    for (std::size_t i = 0; i < EVENTS; i++)
+        fds[i] = -1;
+#ifdef __linux__
+    fds[Cycles] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    fds[Instructions] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    fds[L1dMisses] = open(PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_L1D));
+    // the generic event; the LL cache event is missing on many AMD parts
+    fds[LlcMisses] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    fds[BranchMisses] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    fds[DtlbMisses] = open(PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_DTLB));
+#endif
+  }
+
+  ~PerfCounters()
+  {
+    close();
+  }
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  // Counters of the benchmark's (single) thread, opened on first use.
+  static PerfCounters& process()
+  {
+    static PerfCounters counters;
+    return counters;
+  }
+
+  static const char * eventName(Event event)
+  {
+    static const char * const names[EVENTS] =
+      { "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "dtlb_misses" };
+    return names[event];
+  }
+
+  bool available(Event event) const
+  {
+    return fds[event] >= 0;
+  }
+
+  bool available() const
+  {
+    for (std::size_t i = 0; i < EVENTS; i++)
+        if (fds[i] >= 0)
+            return true;
+    return false;
+  }
+
+  // Stops counting for good; available() is false afterwards.
+  void close()
+  {
+    for (std::size_t i = 0; i < EVENTS; i++)
+    {
+#ifdef __linux__
+        if (fds[i] >= 0)
+            ::close(fds[i]);
+#endif
+        fds[i] = -1;
+    }
+  }
+
+  // Current totals; unavailable events read 0. Costs a system call per
+  // event, so read around many operations, not around each one.
+  Reading read() const
+  {
+    Reading reading;
+#ifdef __linux__
+    for (std::size_t i = 0; i < EVENTS; i++)
+    {
+        std::uint64_t data[3];
+        if (fds[i] < 0 || ::read(fds[i], data, sizeof(data)) != sizeof(data) || data[2] == 0)
+            continue;
+        reading.values[i] = static_cast<double>(data[0]) * data[1] / data[2];
+    }
+#endif
+    return reading;
+  }
+};
+
+}
+}
+
+#endif /* AISDI_MAPS_PERFCOUNTERS_H */
@@ -0,0 +1,62 @@
+#ifndef AISDI_MAPS_PERFECTHASH_H
+#define AISDI_MAPS_PERFECTHASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace aisdi
+{
+
+// The hash-and-displace functions shared by FrozenHashMap, built at run
+// time, and StaticHashMap, built at compile time. A key's 64-bit hash
+// picks its group; the group's pilot, found by trying 0, 1, 2... until
+// every key of the group lands in a free slot, picks the slot.
+struct PerfectHash
+{
+  // splitmix64's finalizer, applied to bucketHash(key) ^ seed
+  static constexpr std::uint64_t mix(std::uint64_t x)
+  {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+  }
+
+  // Lemire's fast range: x scaled from [0, 2^32) down to [0, n)
+  static constexpr std::size_t reduce(std::uint32_t x, std::size_t n)
+  {
+    return static_cast<std::size_t>((static_cast<std::uint64_t>(x) * n) >> 32);
+  }
+
+  // PTHash's skewed split: 60% of the keys share the first 30% of the
+  // groups. The large groups, placed first into a nearly empty table, then
+  // take most keys, and few small groups are left for the nearly full one.
+  static constexpr std::size_t groupOf(std::uint64_t hash, std::size_t groups)
+  {
+    const std::uint32_t dense = 0x9999999A;
+    std::uint32_t x = static_cast<std::uint32_t>(hash);
+    std::uint32_t skewed = x < dense ? x >> 1 : (dense >> 1) + static_cast<std::uint32_t>(
+        (static_cast<std::uint64_t>(x - dense) * 7) >> 2);
+    return reduce(skewed, groups);
+  }
+
+  // The multiply carries every bit of the displaced hash into the high
+  // half, so keys of one group whose hashes differ in a few bits only
+  // still move independently as the pilot changes.
+  static constexpr std::size_t slotOf(std::uint64_t hash, std::uint32_t pilot, std::size_t n)
+  {
+    std::uint64_t displaced = (hash ^ (pilot * 0x9E3779B97F4A7C15ull)) * 0xBF58476D1CE4E5B9ull;
+    return reduce(static_cast<std::uint32_t>(displaced >> 32), n);
+  }
+
+  // the seed of the given construction attempt
+  static constexpr std::uint64_t seed(unsigned int attempt)
+  {
+    return mix(attempt + 0x9E3779B97F4A7C15ull);
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_PERFECTHASH_H */
@@ -0,0 +1,20 @@
+#ifndef AISDI_MAPS_PREFETCH_H
+#define AISDI_MAPS_PREFETCH_H
+
+namespace aisdi
+{
+
+// Asks the CPU to start loading the cache line at address, without waiting
+// for it. Compiles to nothing on compilers without the builtin.
+inline void prefetch(const void * address)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(address);
+#else
+  (void)address;
+#endif
+}
+
+}
+
+#endif /* AISDI_MAPS_PREFETCH_H */
@@ -0,0 +1,279 @@
+#ifndef AISDI_MAPS_READMOSTLYHASHMAP_H
+#define AISDI_MAPS_READMOSTLYHASHMAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <HashMap.h>
+
+namespace aisdi
+{
+
+// Epoch-based reclamation. Every reading thread owns a Record (on its own
+// cache line) where it announces the global epoch it entered with, or 0 when
+// it is outside a read section. A writer that unpublished some memory bumps
+// the global epoch and waits until no thread is still inside an older epoch;
+// after that nobody can hold a pointer to the old memory.
+class EpochDomain
+{
+public:
+  struct Record
+  {
+    std::atomic<std::uint64_t> epoch;
+    std::atomic<bool> used;
+    Record * next;
+    // only touched by the owning thread
+    unsigned int depth;
+    char padding[64];
+
+    Record() : epoch(0), used(true), next(nullptr), depth(0)
+    {}
+  };
+
+private:
+  std::atomic<std::uint64_t> globalEpoch;
+  std::atomic<Record*> records;
+
+  struct ThreadRecord
+  {
+    Record * record;
+
+    ThreadRecord() : record(EpochDomain::global().acquire())
+    {}
+
+    ~ThreadRecord()
+    {
+      EpochDomain::global().release(record);
+    }
+  };
+
+public:
+  EpochDomain() : globalEpoch(1), records(nullptr)
+  {}
+
+  ~EpochDomain()
+  {
+    Record * record = records.load();
+    while (record)
+    {
+        Record * next = record->next;
+        delete record;
+        record = next;
+    }
+  }
+
+  EpochDomain(const EpochDomain&) = delete;
+  EpochDomain& operator=(const EpochDomain&) = delete;
+
+  static EpochDomain& global()
+  {
+    static EpochDomain domain;
+    return domain;
+  }
+
+  // Record of the calling thread, registered on first use and handed back
+  // to the domain when the thread exits.
+  static Record * threadRecord()
+  {
+    static thread_local ThreadRecord holder;
+    return holder.record;
+  }
+
+  // Reuses a record left by a finished thread, or appends a new one.
+  Record * acquire()
+  {
+    for (Record * record = records.load(std::memory_order_acquire); record; record = record->next)
+    {
+        bool expected = false;
+        if (record->used.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            return record;
+    }
+    Record * record = new Record;
+    record->next = records.load(std::memory_order_relaxed);
+    while (!records.compare_exchange_weak(record->next, record, std::memory_order_release));
+    return record;
+  }
+
+  void release(Record * record)
+  {
+    record->epoch.store(0, std::memory_order_release);
+    record->depth = 0;
+    record->used.store(false, std::memory_order_release);
+  }
+
+  // Read sections nest; only the outermost one is announced.
+  void enter(Record * record)
+  {
+    // seq_cst like synchronize's advance, so a reader that sees the new
+    // epoch also sees the snapshot published before it
+    if (record->depth++ == 0)
+        record->epoch.store(globalEpoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+  }
+
+  void leave(Record * record)
+  {
+    if (--record->depth == 0)
+        record->epoch.store(0, std::memory_order_release);
+  }
+
+  // Waits until every read section that started before this call has ended.
+  // Must not be called from inside a read section.
+  void synchronize()
+  {
+    std::uint64_t target = globalEpoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+    for (Record * record = records.load(std::memory_order_acquire); record; record = record->next)
+    {
+        for (;;)
+        {
+            std::uint64_t epoch = record->epoch.load(std::memory_order_seq_cst);
+            if (epoch == 0 || epoch >= target)
+                break;
+            std::this_thread::yield();
+        }
+    }
+  }
+};
+
+// Hash map for tables that are read far more often than written.
+// Readers never take a lock and never write memory shared with other
+// threads: they announce themselves in their own epoch record and follow
+// one atomic pointer to an immutable HashMap snapshot. Writers are
+// serialized, copy the current snapshot, modify the copy, publish it and
+// free the old one once all readers that could see it have left.
+// Every write therefore costs O(n); batch them with update().
+template <typename KeyType, typename ValueType>
+class ReadMostlyHashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using size_type = std::size_t;
+  using snapshot_type = HashMap<KeyType, ValueType>;
+
+private:
+  std::atomic<const snapshot_type*> current;
+  std::mutex writerMutex;
+
+  class ReadGuard
+  {
+  private:
+    EpochDomain::Record * record;
+
+  public:
+    ReadGuard() : record(EpochDomain::threadRecord())
+    {
+      EpochDomain::global().enter(record);
+    }
+
+    ~ReadGuard()
+    {
+      EpochDomain::global().leave(record);
+    }
+
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+  };
+
+  void publish(std::unique_ptr<snapshot_type> next)
+  {
+    const snapshot_type * old = current.exchange(next.release(), std::memory_order_seq_cst);
+    EpochDomain::global().synchronize();
+    delete old;
+  }
+
+public:
+  ReadMostlyHashMap() : current(new snapshot_type)
+  {}
+
+  explicit ReadMostlyHashMap(const snapshot_type& initial) : current(new snapshot_type(initial))
+  {}
+
+  ~ReadMostlyHashMap()
+  {
+    delete current.load();
+  }
+
+  ReadMostlyHashMap(const ReadMostlyHashMap&) = delete;
+  ReadMostlyHashMap& operator=(const ReadMostlyHashMap&) = delete;
+
+  // Copies the value into out and returns true when the key is present.
+  bool find(const key_type& key, mapped_type& out) const
+  {
+    ReadGuard guard;
+    const mapped_type * value = current.load(std::memory_order_seq_cst)->tryGet(key);
+    if (value == nullptr)
+        return false;
+    out = *value;
+    return true;
+  }
+
+  bool contains(const key_type& key) const
+  {
+    ReadGuard guard;
+    return current.load(std::memory_order_seq_cst)->contains(key);
+  }
+
+  size_type getSize() const
+  {
+    ReadGuard guard;
+    return current.load(std::memory_order_seq_cst)->getSize();
+  }
+
+  bool isEmpty() const
+  {
+    return getSize() == 0;
+  }
+
+  // Runs visitor on one consistent snapshot. The snapshot (and anything
+  // referenced in it) is valid only until visitor returns.
+  template <typename Visitor>
+  auto read(Visitor visitor) const -> decltype(visitor(std::declval<const snapshot_type&>()))
+  {
+    ReadGuard guard;
+    return visitor(*current.load(std::memory_order_seq_cst));
+  }
+
+  // Applies mutator to a private copy of the table and publishes the result
+  // atomically, so readers see either none or all of its changes.
+  template <typename Mutator>
+  void update(Mutator mutator)
+  {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    std::unique_ptr<snapshot_type> next(new snapshot_type(*current.load(std::memory_order_relaxed)));
+    mutator(*next);
+    publish(std::move(next));
+  }
+
+  void insertOrAssign(const key_type& key, const mapped_type& value)
+  {
+    update([&key, &value](snapshot_type& map) { map[key] = value; });
+  }
+
+  // Returns true if the key was present.
+  bool remove(const key_type& key)
+  {
+    bool found = false;
+    update([&key, &found](snapshot_type& map)
+    {
+      auto it = map.find(key);
+      found = (it != map.end());
+      if (found)
+          map.remove(it);
+    });
+    return found;
+  }
+
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    publish(std::unique_ptr<snapshot_type>(new snapshot_type));
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_READMOSTLYHASHMAP_H */
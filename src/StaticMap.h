@@ -0,0 +1,327 @@
+#ifndef AISDI_MAPS_STATICMAP_H
+#define AISDI_MAPS_STATICMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <BucketPolicy.h>
+#include <PerfectHash.h>
+
+namespace aisdi
+{
+
+// Maps over a literal table, built entirely by the compiler when declared
+// constexpr, so that they sit in read-only data and program start does no
+// work for them (unlike the initializer list constructors of TreeMap and
+// HashMap):
+//
+//   constexpr aisdi::StaticEntry<int, const char*> ports[] = {
+//     { 22, "ssh" }, { 80, "http" }, { 443, "https" } };
+//   constexpr auto byPort = aisdi::makeStaticHashMap(ports);
+//   static_assert(byPort.contains(80), "");
+//
+// Keys and values must be literal types. A duplicate key fails the
+// compilation (or throws std::invalid_argument when built at run time).
+// Lookups have the interface of the other maps and are constexpr too.
+
+// The entry type of the static maps; an aggregate, so that a table can
+// be written as a braced list.
+template <typename KeyType, typename ValueType>
+struct StaticEntry
+{
+  KeyType first;
+  ValueType second;
+};
+
+// Entries sorted by key, searched by a binary search whose loop has no
+// branch on the keys (a conditional move per step). Any key with < and ==.
+template <typename KeyType, typename ValueType, std::size_t N>
+class StaticFlatMap
+{
+  static_assert(N > 0, "a static map needs at least one entry");
+
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = StaticEntry<key_type, mapped_type>;
+  using size_type = std::size_t;
+  using const_reference = const value_type&;
+  using const_iterator = const value_type*;
+  using iterator = const_iterator;
+
+private:
+  value_type entries[N];
+
+  constexpr const_iterator lowerBound(const key_type& key) const
+  {
+    const value_type* base = entries;
+    std::size_t size = N;
+    while (size > 1)
+    {
+        std::size_t half = size / 2;
+        base = base[half].first < key ? base + half : base;
+        size -= half;
+    }
+    return base + (base->first < key);
+  }
+
+public:
+  // Insertion sort: the tables are small, and it runs once, in the compiler.
+  constexpr explicit StaticFlatMap(const value_type (&list)[N]) : entries()
+  {
+    for (std::size_t i = 0; i < N; i++)
+    {
+        value_type entry = list[i];
+        std::size_t j = i;
+        for (; j > 0 && entry.first < entries[j - 1].first; j--)
+            entries[j] = entries[j - 1];
+        entries[j] = entry;
+    }
+    for (std::size_t i = 1; i < N; i++)
+        if (!(entries[i - 1].first < entries[i].first))
+            throw std::invalid_argument("StaticFlatMap: duplicate key");
+  }
+
+  constexpr const_iterator find(const key_type& key) const
+  {
+    const_iterator entry = lowerBound(key);
+    return entry != end() && entry->first == key ? entry : end();
+  }
+
+  constexpr const mapped_type& valueOf(const key_type& key) const
+  {
+    const_iterator entry = find(key);
+    if (entry == end())
+        throw std::out_of_range("");
+    return entry->second;
+  }
+
+  // Non-throwing lookup: returns nullptr when the key is missing.
+  constexpr const mapped_type* tryGet(const key_type& key) const
+  {
+    const_iterator entry = find(key);
+    return entry != end() ? &entry->second : nullptr;
+  }
+
+  constexpr bool contains(const key_type& key) const
+  {
+    return find(key) != end();
+  }
+
+  static constexpr size_type getSize()
+  {
+    return N;
+  }
+
+  constexpr const_iterator begin() const
+  {
+    return entries;
+  }
+
+  constexpr const_iterator end() const
+  {
+    return entries + N;
+  }
+
+  constexpr const_iterator cbegin() const
+  {
+    return begin();
+  }
+
+  constexpr const_iterator cend() const
+  {
+    return end();
+  }
+};
+
+// A minimal perfect hash over integer-like keys (see bucketHash()), as in
+// FrozenHashMap but searched for by the compiler: every entry has its own
+// slot, and a lookup is one hash, one pilot and one key comparison with no
+// other branch. GCC 12 builds a table of 16000 entries, in about five
+// seconds, within its default constexpr operation limit; 32000 need
+// -fconstexpr-ops-limit raised.
+template <typename KeyType, typename ValueType, std::size_t N>
+class StaticHashMap
+{
+  static_assert(N > 0, "a static map needs at least one entry");
+
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = StaticEntry<key_type, mapped_type>;
+  using size_type = std::size_t;
+  using const_reference = const value_type&;
+  using const_iterator = const value_type*;
+  using iterator = const_iterator;
+
+private:
+  // two keys per group: the pilots of a small table cost little
+  static const std::size_t GROUPS = (N + 1) / 2;
+  static const unsigned int ATTEMPTS = 16;
+  static const std::uint32_t MAX_PILOT = 1 << 16;
+
+  value_type entries[N];
+  std::uint32_t pilots[GROUPS];
+  std::uint64_t seed;
+
+  constexpr std::uint64_t hash(const key_type& key) const
+  {
+    return PerfectHash::mix(bucketHash(key) ^ seed);
+  }
+
+  // Fails when two distinct keys hash alike under the current seed or a
+  // group runs out of pilots.
+  constexpr bool tryBuild(const value_type (&list)[N])
+  {
+    std::uint64_t hashes[N] = {};
+    std::size_t groupStart[GROUPS + 1] = {};
+    for (std::size_t i = 0; i < N; i++)
+    {
+        hashes[i] = hash(list[i].first);
+        groupStart[PerfectHash::groupOf(hashes[i], GROUPS) + 1]++;
+    }
+    for (std::size_t group = 0; group < GROUPS; group++)
+        groupStart[group + 1] += groupStart[group];
+    std::size_t grouped[N] = {};
+    std::size_t cursor[GROUPS] = {};
+    for (std::size_t group = 0; group < GROUPS; group++)
+        cursor[group] = groupStart[group];
+    for (std::size_t i = 0; i < N; i++)
+        grouped[cursor[PerfectHash::groupOf(hashes[i], GROUPS)]++] = i;
+
+    // equal hashes always share a group
+    std::size_t largest = 0;
+    for (std::size_t group = 0; group < GROUPS; group++)
+    {
+        for (std::size_t a = groupStart[group]; a < groupStart[group + 1]; a++)
+            for (std::size_t b = a + 1; b < groupStart[group + 1]; b++)
+                if (hashes[grouped[a]] == hashes[grouped[b]])
+                {
+                    if (list[grouped[a]].first == list[grouped[b]].first)
+                        throw std::invalid_argument("StaticHashMap: duplicate key");
+                    return false;
+                }
+        if (groupStart[group + 1] - groupStart[group] > largest)
+            largest = groupStart[group + 1] - groupStart[group];
+    }
+
+    // the largest groups go first, while most slots are still free
+    bool taken[N] = {};
+    std::size_t slots[N] = {};
+    for (std::size_t size = largest; size > 0; size--)
+        for (std::size_t group = 0; group < GROUPS; group++)
+        {
+            const std::size_t first = groupStart[group];
+            const std::size_t last = groupStart[group + 1];
+            if (last - first != size)
+                continue;
+            std::uint32_t pilot = 0;
+            for (;; pilot++)
+            {
+                if (pilot == MAX_PILOT)
+                    return false;
+                std::size_t placed = first;
+                for (; placed < last; placed++)
+                {
+                    slots[placed] = PerfectHash::slotOf(hashes[grouped[placed]], pilot, N);
+                    if (taken[slots[placed]])
+                        break;
+                    taken[slots[placed]] = true;
+                }
+                if (placed == last)
+                    break;
+                while (placed-- > first)
+                    taken[slots[placed]] = false;
+            }
+            pilots[group] = pilot;
+        }
+
+    for (std::size_t pos = 0; pos < N; pos++)
+        entries[slots[pos]] = list[grouped[pos]];
+    return true;
+  }
+
+public:
+  constexpr explicit StaticHashMap(const value_type (&list)[N]) : entries(), pilots(), seed(0)
+  {
+    for (unsigned int attempt = 0;; attempt++)
+    {
+        if (attempt == ATTEMPTS)
+            throw std::runtime_error("StaticHashMap: no perfect hash found");
+        seed = PerfectHash::seed(attempt);
+        if (tryBuild(list))
+            return;
+    }
+  }
+
+  constexpr const_iterator find(const key_type& key) const
+  {
+    std::uint64_t h = hash(key);
+    const_iterator entry = entries + PerfectHash::slotOf(h, pilots[PerfectHash::groupOf(h, GROUPS)], N);
+    return entry->first == key ? entry : end();
+  }
+
+  constexpr const mapped_type& valueOf(const key_type& key) const
+  {
+    const_iterator entry = find(key);
+    if (entry == end())
+        throw std::out_of_range("");
+    return entry->second;
+  }
+
+  // Non-throwing lookup: returns nullptr when the key is missing.
+  constexpr const mapped_type* tryGet(const key_type& key) const
+  {
+    const_iterator entry = find(key);
+    return entry != end() ? &entry->second : nullptr;
+  }
+
+  constexpr bool contains(const key_type& key) const
+  {
+    return find(key) != end();
+  }
+
+  static constexpr size_type getSize()
+  {
+    return N;
+  }
+
+  constexpr const_iterator begin() const
+  {
+    return entries;
+  }
+
+  constexpr const_iterator end() const
+  {
+    return entries + N;
+  }
+
+  constexpr const_iterator cbegin() const
+  {
+    return begin();
+  }
+
+  constexpr const_iterator cend() const
+  {
+    return end();
+  }
+};
+
+// Deduce the table size: makeStaticFlatMap(table) for a named array, or
+// makeStaticFlatMap<int, const char*>({ { 1, "one" }, ... }) for a
+// braced list.
+template <typename KeyType, typename ValueType, std::size_t N>
+constexpr StaticFlatMap<KeyType, ValueType, N> makeStaticFlatMap(const StaticEntry<KeyType, ValueType> (&list)[N])
+{
+  return StaticFlatMap<KeyType, ValueType, N>(list);
+}
+
+template <typename KeyType, typename ValueType, std::size_t N>
+constexpr StaticHashMap<KeyType, ValueType, N> makeStaticHashMap(const StaticEntry<KeyType, ValueType> (&list)[N])
+{
+  return StaticHashMap<KeyType, ValueType, N>(list);
+}
+
+}
+
+#endif /* AISDI_MAPS_STATICMAP_H */
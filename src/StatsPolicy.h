@@ -0,0 +1,139 @@
+#ifndef AISDI_MAPS_STATSPOLICY_H
+#define AISDI_MAPS_STATSPOLICY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace aisdi
+{
+
+// Operation counts of one map, see TreeMap::counters(). probes is the
+// number of tree nodes visited by all key searches (lookups and inserts).
+struct MapCounters
+{
+  std::uint64_t hits;
+  std::uint64_t misses;
+  std::uint64_t inserts;
+  std::uint64_t erases;
+  std::uint64_t probes;
+
+  MapCounters& operator+=(const MapCounters& other)
+  {
+    hits += other.hits;
+    misses += other.misses;
+    inserts += other.inserts;
+    erases += other.erases;
+    probes += other.probes;
+    return *this;
+  }
+
+  // nodes visited per key search
+  double averageProbeLength() const
+  {
+    std::uint64_t searches = hits + misses + inserts;
+    return searches ? static_cast<double>(probes) / searches : 0.0;
+  }
+};
+
+// Statistics policies: the last template parameter of TreeMap and
+// HashMap, which the maps inherit from (privately, so that an empty policy
+// takes no space) and call on every lookup, insertion and removal. Calls
+// are const, lookups being const.
+
+// The default: every call is empty and inlines to nothing, so maps without
+// statistics compile to the same code as before the policy existed.
+class NoStats
+{
+protected:
+  void recordLookup(bool, std::size_t) const
+  {}
+
+  void recordInsert(std::size_t) const
+  {}
+
+  void recordErase() const
+  {}
+
+  MapCounters readCounters() const
+  {
+    return MapCounters();
+  }
+
+  void resetCounters()
+  {}
+};
+
+// Counts with relaxed atomic increments: several readers may search a map
+// at once (ConcurrentHashMap shards under a shared lock), and the counts
+// order nothing. A snapshot taken while others update the map is not
+// atomic as a whole. Copies and moves of a map start from zero.
+class CountingStats
+{
+private:
+  mutable std::atomic<std::uint64_t> hits;
+  mutable std::atomic<std::uint64_t> misses;
+  mutable std::atomic<std::uint64_t> inserts;
+  mutable std::atomic<std::uint64_t> erases;
+  mutable std::atomic<std::uint64_t> probes;
+
+  static void add(std::atomic<std::uint64_t>& counter, std::uint64_t value)
+  {
+    counter.fetch_add(value, std::memory_order_relaxed);
+  }
+
+protected:
+  CountingStats()
+  {
+    resetCounters();
+  }
+
+  CountingStats(const CountingStats&) : CountingStats()
+  {}
+
+  CountingStats& operator=(const CountingStats&)
+  {
+    return *this;
+  }
+
+  void recordLookup(bool hit, std::size_t visited) const
+  {
+    add(hit ? hits : misses, 1);
+    add(probes, visited);
+  }
+
+  void recordInsert(std::size_t visited) const
+  {
+    add(inserts, 1);
+    add(probes, visited);
+  }
+
+  void recordErase() const
+  {
+    add(erases, 1);
+  }
+
+  MapCounters readCounters() const
+  {
+    MapCounters counters;
+    counters.hits = hits.load(std::memory_order_relaxed);
+    counters.misses = misses.load(std::memory_order_relaxed);
+    counters.inserts = inserts.load(std::memory_order_relaxed);
+    counters.erases = erases.load(std::memory_order_relaxed);
+    counters.probes = probes.load(std::memory_order_relaxed);
+    return counters;
+  }
+
+  void resetCounters()
+  {
+    hits.store(0, std::memory_order_relaxed);
+    misses.store(0, std::memory_order_relaxed);
+    inserts.store(0, std::memory_order_relaxed);
+    erases.store(0, std::memory_order_relaxed);
+    probes.store(0, std::memory_order_relaxed);
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_STATSPOLICY_H */
@@ -0,0 +1,342 @@
+#ifndef AISDI_MAPS_TRACE_H
+#define AISDI_MAPS_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace aisdi
+{
+
+// Binary trace of map operations, for replaying captured traffic.
+// A trace is the 8 byte magic "AISDITR1" followed by records:
+//   opcode (1 byte) [key] [count]
+// Keys are stored as the zigzag-encoded difference to the previous key of
+// the trace and counts as unsigned LEB128 varints, so runs of near keys
+// take 2-3 bytes per operation and random 64-bit keys about 10.
+struct TraceEntry
+{
+  enum Operation : std::uint8_t
+  {
+    Insert = 1,    // key
+    Lookup = 2,    // key
+    Remove = 3,    // key
+    Iterate = 4,   // whole map, in iteration order
+    Range = 5,     // key, count: up to count items from key on
+    Clear = 6
+  };
+
+  Operation operation;
+  std::uint64_t key;
+  std::uint64_t count;
+
+  static bool hasKey(Operation operation)
+  {
+    return operation == Insert || operation == Lookup || operation == Remove || operation == Range;
+  }
+};
+
+class TraceWriter
+{
+private:
+  static const std::size_t BUFFER = 1 << 16;
+
+  std::ostream& out;
+  std::vector<char> buffer;
+  std::uint64_t previousKey;
+  std::uint64_t entries;
+
+  void putVarint(std::uint64_t value)
+  {
+    while (value >= 0x80)
+    {
+        buffer.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<char>(value));
+  }
+
+public:
+  explicit TraceWriter(std::ostream& out) : out(out), previousKey(0), entries(0)
+  {
+    buffer.reserve(BUFFER + 32);
+    out.write("AISDITR1", 8);
+  }
+
+  ~TraceWriter()
+  {
+    flush();
+  }
+
+  TraceWriter(const TraceWriter&) = delete;
+  TraceWriter& operator=(const TraceWriter&) = delete;
+
+  void write(TraceEntry::Operation operation, std::uint64_t key = 0, std::uint64_t count = 0)
+  {
+    buffer.push_back(static_cast<char>(operation));
+    if (TraceEntry::hasKey(operation))
+    {
+        std::uint64_t delta = key - previousKey;
+        putVarint((delta << 1) ^ (0 - (delta >> 63)));
+        previousKey = key;
+    }
+    if (operation == TraceEntry::Range)
+        putVarint(count);
+    entries++;
+    if (buffer.size() >= BUFFER)
+        flush();
+  }
+
+  void flush()
+  {
+    out.write(buffer.data(), buffer.size());
+    out.flush();
+    buffer.clear();
+  }
+
+  std::uint64_t getEntries() const
+  {
+    return entries;
+  }
+};
+
+// Decodes a whole trace up front, so that replaying it measures the maps
+// and not the decoder. Throws std::invalid_argument on malformed input.
+inline std::vector<TraceEntry> readTrace(std::istream& in)
+{
+  std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  if (bytes.size() < 8 || std::memcmp(bytes.data(), "AISDITR1", 8) != 0)
+    throw std::invalid_argument("not a map operation trace");
+
+  std::size_t position = 8;
+  auto getVarint = [&]()
+  {
+    std::uint64_t value = 0;
+    for (unsigned int shift = 0; ; shift += 7)
+    {
+        if (position == bytes.size() || shift > 63)
+            throw std::invalid_argument("truncated trace");
+        std::uint8_t byte = static_cast<std::uint8_t>(bytes[position++]);
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+  };
+
+  std::vector<TraceEntry> entries;
+  std::uint64_t previousKey = 0;
+  while (position < bytes.size())
+  {
+    TraceEntry entry;
+    std::uint8_t operation = static_cast<std::uint8_t>(bytes[position++]);
+    if (operation < TraceEntry::Insert || operation > TraceEntry::Clear)
+        throw std::invalid_argument("unknown trace operation");
+    entry.operation = static_cast<TraceEntry::Operation>(operation);
+    entry.key = 0;
+    entry.count = 0;
+    if (TraceEntry::hasKey(entry.operation))
+    {
+        std::uint64_t zigzag = getVarint();
+        previousKey += (zigzag >> 1) ^ (0 - (zigzag & 1));
+        entry.key = previousKey;
+    }
+    if (entry.operation == TraceEntry::Range)
+        entry.count = getVarint();
+    entries.push_back(entry);
+  }
+  return entries;
+}
+
+// Wraps a TreeMap or HashMap with integer keys and writes every operation
+// made through it to a trace. Values are not recorded; a replay inserts
+// its own. begin() is recorded as a full iteration, forRange() as a range.
+template <typename Map>
+class TraceRecorder
+{
+public:
+  using map_type = Map;
+  using key_type = typename Map::key_type;
+  using mapped_type = typename Map::mapped_type;
+  using value_type = typename Map::value_type;
+  using size_type = typename Map::size_type;
+  using iterator = typename Map::iterator;
+  using const_iterator = typename Map::const_iterator;
+
+  static_assert(std::is_integral<key_type>::value, "traces store integer keys");
+
+private:
+  Map map;
+  mutable TraceWriter writer;
+
+  void record(TraceEntry::Operation operation, const key_type& key = key_type(),
+              std::uint64_t count = 0) const
+  {
+    writer.write(operation, static_cast<std::uint64_t>(key), count);
+  }
+
+public:
+  explicit TraceRecorder(std::ostream& out) : writer(out)
+  {}
+
+  TraceRecorder(Map map, std::ostream& out) : map(std::move(map)), writer(out)
+  {}
+
+  mapped_type& operator[](const key_type& key)
+  {
+    record(TraceEntry::Insert, key);
+    return map[key];
+  }
+
+  std::pair<iterator, bool> insertOrGet(const key_type& key)
+  {
+    record(TraceEntry::Insert, key);
+    return map.insertOrGet(key);
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    record(TraceEntry::Lookup, key);
+    return map.valueOf(key);
+  }
+
+  mapped_type& valueOf(const key_type& key)
+  {
+    record(TraceEntry::Lookup, key);
+    return map.valueOf(key);
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    record(TraceEntry::Lookup, key);
+    return map.find(key);
+  }
+
+  iterator find(const key_type& key)
+  {
+    record(TraceEntry::Lookup, key);
+    return map.find(key);
+  }
+
+  const mapped_type * tryGet(const key_type& key) const
+  {
+    record(TraceEntry::Lookup, key);
+    return map.tryGet(key);
+  }
+
+  mapped_type * tryGet(const key_type& key)
+  {
+    record(TraceEntry::Lookup, key);
+    return map.tryGet(key);
+  }
+
+  bool contains(const key_type& key) const
+  {
+    record(TraceEntry::Lookup, key);
+    return map.contains(key);
+  }
+
+  void remove(const key_type& key)
+  {
+    record(TraceEntry::Remove, key);
+    map.remove(key);
+  }
+
+  void remove(const const_iterator& it)
+  {
+    if (it != map.cend())
+        record(TraceEntry::Remove, it->first);
+    map.remove(it);
+  }
+
+  // Calls visit(item) for up to count items, starting at key in iteration
+  // order; nothing if key is missing.
+  template <typename Visitor>
+  void forRange(const key_type& key, size_type count, Visitor visit) const
+  {
+    record(TraceEntry::Range, key, count);
+    const_iterator it = map.find(key);
+    for (size_type visited = 0; visited < count && it != map.cend(); visited++, ++it)
+        visit(*it);
+  }
+
+  iterator begin()
+  {
+    record(TraceEntry::Iterate);
+    return map.begin();
+  }
+
+  const_iterator begin() const
+  {
+    record(TraceEntry::Iterate);
+    return map.begin();
+  }
+
+  const_iterator cbegin() const
+  {
+    return begin();
+  }
+
+  iterator end()
+  {
+    return map.end();
+  }
+
+  const_iterator end() const
+  {
+    return map.end();
+  }
+
+  const_iterator cend() const
+  {
+    return map.cend();
+  }
+
+  size_type getSize() const
+  {
+    return map.getSize();
+  }
+
+  bool isEmpty() const
+  {
+    return map.isEmpty();
+  }
+
+  void clear()
+  {
+    record(TraceEntry::Clear);
+    map.clear();
+  }
+
+  // Writes buffered records out; also done on destruction.
+  void flush()
+  {
+    writer.flush();
+  }
+
+  std::uint64_t getRecorded() const
+  {
+    return writer.getEntries();
+  }
+
+  // The wrapped map; operations made directly on it are not recorded.
+  Map& underlying()
+  {
+    return map;
+  }
+
+  const Map& underlying() const
+  {
+    return map;
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_TRACE_H */
@@ -1,18 +1,62 @@
 #ifndef AISDI_MAPS_TREEMAP_H
 #define AISDI_MAPS_TREEMAP_H
 
+#include <algorithm>
 #include <cstddef>
 #include <initializer_list>
+#include <map>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 #include <iostream>
+#include <EventHooks.h>
+#include <Prefetch.h>
+#include <StatsPolicy.h>
 
 
 namespace aisdi
 {
 
-template <typename KeyType, typename ValueType>
-class TreeMap
+// Called for every node a key search steps on. Does nothing; key types
+// that want the count specialize it (see InstrumentedKey.h).
+template <typename KeyType>
+struct NodeVisits
+{
+  static void count()
+  {}
+};
+
+// Shape of a TreeMap, see TreeMap::stats(). Depths count edges from the
+// root (depth 0); height counts levels, so it is maxDepth + 1, or 0 for
+// an empty tree.
+struct TreeStats
+{
+  std::size_t size;
+  std::size_t height;
+  std::size_t maxDepth;
+  double averageDepth;
+  // nodes at each depth
+  std::vector<std::size_t> depthHistogram;
+  // height of the right subtree minus height of the left one -> nodes
+  std::map<long, std::size_t> balanceFactors;
+  // nodes whose balance factor is outside [-1, 1]
+  std::size_t unbalancedNodes;
+  // heap bytes requested for the nodes and their entries
+  std::size_t nodeBytes;
+
+  // height of a perfectly balanced tree of the same size
+  std::size_t minimalHeight() const
+  {
+    std::size_t levels=0;
+    for (std::size_t n=size; n>0; n/=2)
+        levels++;
+    return levels;
+  }
+};
+
+// Stats is a statistics policy from StatsPolicy.h; NoStats costs nothing.
+template <typename KeyType, typename ValueType, typename Stats = NoStats>
+class TreeMap : private Stats
 {
 private:
 
@@ -27,6 +71,9 @@ private:
     Item(KeyType key, ValueType value)
     {
         para = new std::pair <const KeyType, ValueType>(key,value);
+        left=nullptr;
+        right=nullptr;
+        parent=nullptr;
     }
 
     Item()
@@ -50,6 +97,9 @@ private:
   Item * root;
   size_t size;
 
+  static const std::size_t INTERLEAVE=16;
+  static const std::size_t CHUNK=64;
+
   Item * findSmallest(Item * item) const
   {
    if (item==nullptr) return nullptr;
@@ -57,6 +107,34 @@ private:
    return item;
   }
 
+  // Node holding key, or nullptr; visited counts the nodes stepped on.
+  Item * findItem(const KeyType& key, std::size_t& visited) const
+  {
+    Item * item = root;
+    while (item!=nullptr)
+    {
+        visited++;
+        NodeVisits<KeyType>::count();
+        if (!(item->para->first!=key))
+            break;
+        if (key>item->para->first)
+            item=item->right;
+        else
+            item=item->left;
+    }
+    return item;
+  }
+
+  // findItem for lookups, counted in the statistics. Shared by every lookup
+  // so that hits and misses take the same path and none of them throws.
+  Item * lookupItem(const KeyType& key) const
+  {
+    std::size_t visited=0;
+    Item * item = findItem(key, visited);
+    Stats::recordLookup(item!=nullptr, visited);
+    return item;
+  }
+
   Item * findLargest(Item * item) const
   {
     if (item==nullptr) return nullptr;
@@ -64,19 +142,42 @@ private:
     return item;
   }
 
-  void clean_tree(Item* t)
+  // Copies the shape of the tree node by node, so copying costs O(n)
+  // whatever order the keys were inserted in (re-inserting them in sorted
+  // order would build a list). Walks both trees through parent pointers
+  // instead of recursing.
+  static Item * cloneTree(const Item * source)
   {
-    if (t->left)
+    if (source==nullptr) return nullptr;
+    Item * copy = new Item(source->para->first, source->para->second);
+    Item * to = copy;
+    const Item * from = source;
+    while (from!=nullptr)
     {
-        clean_tree(t->left);
-    }
-    if (t->right)
-    {
-        clean_tree(t->right);
+        if (from->left!=nullptr && to->left==nullptr)
+        {
+            to->left = new Item(from->left->para->first, from->left->para->second);
+            to->left->parent = to;
+            from=from->left;
+            to=to->left;
+        }
+        else if (from->right!=nullptr && to->right==nullptr)
+        {
+            to->right = new Item(from->right->para->first, from->right->para->second);
+            to->right->parent = to;
+            from=from->right;
+            to=to->right;
+        }
+        else
+        {
+            from = from==source ? nullptr : from->parent;
+            to=to->parent;
+        }
     }
-    delete t;
+    return copy;
   }
 
+
 public:
   using key_type = KeyType;
   using mapped_type = ValueType;
@@ -100,8 +201,8 @@ public:
 
   ~TreeMap()
   {
-    if (!isEmpty())
-        clean_tree(root);
+    MapEvents::Scope event(MapEvent::Destroy, "TreeMap", this, size);
+    clear();
   }
 
   TreeMap(std::initializer_list<value_type> list)
@@ -112,15 +213,14 @@ public:
         (*this)[(*iter).first]=(*iter).second;
   }
 
-  TreeMap(const TreeMap& other)
+  TreeMap(const TreeMap& other) : Stats()
   {
-    root=nullptr;
-    size=0;
-    for(auto iter=other.begin();iter!=other.end();iter++)
-        (*this)[(*iter).first]=(*iter).second;
+    MapEvents::Scope event(MapEvent::Copy, "TreeMap", this, other.size);
+    root=cloneTree(other.root);
+    size=other.size;
   }
 
-  TreeMap(TreeMap&& other)
+  TreeMap(TreeMap&& other) : Stats()
   {
     this->size=other.size;
     this->root=other.root;
@@ -130,23 +230,20 @@ public:
 
   TreeMap& operator=(const TreeMap& other)
   {
-    if (*this==other)
-        return *this;
-    while(size>0)
-        remove(begin());
-    if (other.size==0)
+    if (this==&other)
         return *this;
-    for(auto iter=other.begin();iter!=other.end();iter++)
-        (*this)[iter->first]=iter->second;
+    MapEvents::Scope event(MapEvent::Copy, "TreeMap", this, size+other.size);
+    clear();
+    root=cloneTree(other.root);
+    size=other.size;
     return *this;
   }
 
   TreeMap& operator=(TreeMap&& other)
   {
-    if (*this==other)
+    if (this==&other)
         return *this;
-    while(size>0)
-        remove(begin());
+    clear();
     this->size=other.size;
     this->root=other.root;
     other.size=0;
@@ -160,9 +257,39 @@ public:
     return false;
   }
 
+  // Frees every node in one pass. Left children are rotated up instead of
+  // recursing, so degenerate (list-shaped) trees don't blow the stack.
+  void clear()
+  {
+    MapEvents::Scope event(MapEvent::Clear, "TreeMap", this, size);
+    Item * item = root;
+    while (item)
+    {
+        if (item->left)
+        {
+            Item * left = item->left;
+            item->left = left->right;
+            left->right = item;
+            item = left;
+        }
+        else
+        {
+            Item * right = item->right;
+            delete item;
+            item = right;
+        }
+    }
+    root=nullptr;
+    size=0;
+  }
+
 
-  mapped_type& operator[](const key_type& key)
+  // Looks the key up in a single descent, inserting a default-constructed
+  // value if it is missing. The flag tells whether an insertion took place.
+  std::pair<iterator, bool> insertOrGet(const key_type& key)
   {
+    Iterator iter;
+    iter.tree=this;
     if (isEmpty())
     {
         root = new Item(key, {});
@@ -170,11 +297,15 @@ public:
         root->left=nullptr;
         root->right=nullptr;
         size++;
-        return root->para->second;
+        Stats::recordInsert(0);
+        iter.item=root;
+        return std::make_pair(iter, true);
     }
     Item * item = root;
     int direction;
     Item * father = item;
+    std::size_t visited=1;
+    NodeVisits<KeyType>::count();
     while (item->para->first!=key)
     {
         if (key < item->para->first)
@@ -202,63 +333,160 @@ public:
             item->left=nullptr;
             item->right=nullptr;
             size++;
-            return item->para->second;
+            Stats::recordInsert(visited);
+            iter.item=item;
+            return std::make_pair(iter, true);
         }
+        visited++;
+        NodeVisits<KeyType>::count();
     }
-    return item->para->second;
+    Stats::recordLookup(true, visited);
+    iter.item=item;
+    return std::make_pair(iter, false);
+  }
+
+  mapped_type& operator[](const key_type& key)
+  {
+    return insertOrGet(key).first->second;
   }
 
   const mapped_type& valueOf(const key_type& key) const
   {
-    if (isEmpty())
+    Item * item = lookupItem(key);
+    if (item==nullptr)
         throw std::out_of_range("");
-    Item * item = root;
-    while (item->para->first!=key)
-    {
-        if (key>item->para->first)
-            item=item->right;
-        else
-            item=item->left;
-        if (item==nullptr)
-            throw std::out_of_range("");
-    }
     return item->para->second;
   }
 
   mapped_type& valueOf(const key_type& key)
   {
-    if (isEmpty())
+    Item * item = lookupItem(key);
+    if (item==nullptr)
         throw std::out_of_range("");
-    Item * item = root;
-    while (item->para->first!=key)
-    {
-        if (key>item->para->first)
-            item=item->right;
-        else
-            item=item->left;
-        if (item==nullptr)
-            throw std::out_of_range("");
-    }
     return item->para->second;
   }
 
-  const_iterator find(const key_type& key) const
+  // Non-throwing lookup: returns nullptr when the key is missing.
+  const mapped_type* tryGet(const key_type& key) const
   {
-    ConstIterator iter;
-    Item * item = root;
-    if (root)
+    Item * item = lookupItem(key);
+    return item ? &item->para->second : nullptr;
+  }
+
+  mapped_type* tryGet(const key_type& key)
+  {
+    Item * item = lookupItem(key);
+    return item ? &item->para->second : nullptr;
+  }
+
+  bool contains(const key_type& key) const
+  {
+    return lookupItem(key)!=nullptr;
+  }
+
+  // Interleaved lookup engine (AMAC). Runs count lookups, keys[i] in
+  // *trees[i], keeping up to INTERLEAVE of them in flight. Each step of a
+  // lookup touches memory that was prefetched one step earlier, issues the
+  // prefetch for the next node (or its entry) and moves on to another
+  // lookup, so the dependent cache misses of independent descents overlap.
+  // Writes a pointer to the value, or nullptr, to results[i].
+  static void findInterleaved(const TreeMap * const trees[], const KeyType * const keys[],
+                              const ValueType * results[], std::size_t count)
+  {
+    struct Lookup
     {
-    while (item->para->first!=key)
+      Item * item;
+      std::size_t position;
+      std::size_t visited;
+      bool entryRequested;
+    };
+    Lookup lookups[INTERLEAVE];
+    std::size_t active=0;
+    std::size_t next=0;
+    std::size_t i=0;
+    for (;;)
+    {
+        while (active<INTERLEAVE && next<count)
         {
-            if (key>item->para->first)
-                item=item->right;
+            Item * item=trees[next]->root;
+            if (item==nullptr)
+            {
+                results[next]=nullptr;
+                trees[next]->recordLookup(false, 0);
+            }
             else
-                item=item->left;
-            if (item == nullptr)
-                return cend();
+            {
+                prefetch(item);
+                lookups[active].item=item;
+                lookups[active].position=next;
+                lookups[active].visited=0;
+                lookups[active].entryRequested=false;
+                active++;
+            }
+            next++;
+        }
+        if (active==0)
+            return;
+        if (i>=active)
+            i=0;
+        Lookup& lookup=lookups[i];
+        if (!lookup.entryRequested)
+        {
+            prefetch(lookup.item->para);
+            lookup.entryRequested=true;
+            i++;
+            continue;
         }
+        const KeyType& key=*keys[lookup.position];
+        const KeyType& itemKey=lookup.item->para->first;
+        Item * child=nullptr;
+        lookup.visited++;
+        NodeVisits<KeyType>::count();
+        if (itemKey!=key)
+        {
+            child = key>itemKey ? lookup.item->right : lookup.item->left;
+            if (child!=nullptr)
+            {
+                prefetch(child);
+                lookup.item=child;
+                lookup.entryRequested=false;
+                i++;
+                continue;
+            }
+        }
+        results[lookup.position] = (itemKey!=key) ? nullptr : &lookup.item->para->second;
+        trees[lookup.position]->recordLookup(results[lookup.position]!=nullptr, lookup.visited);
+        lookups[i]=lookups[--active];
     }
-    iter.item=item;
+  }
+
+  // Looks up every key in [keysBegin, keysEnd) with the interleaved engine
+  // and writes a pointer to its value (nullptr on a miss) to out, in order.
+  // Needs forward iterators: keys are referenced, not copied.
+  template <typename ForwardIt, typename OutputIt>
+  OutputIt findMany(ForwardIt keysBegin, ForwardIt keysEnd, OutputIt out) const
+  {
+    const TreeMap * trees[CHUNK];
+    const KeyType * keys[CHUNK];
+    const ValueType * results[CHUNK];
+    for (std::size_t i=0;i<CHUNK;i++)
+        trees[i]=this;
+    while (keysBegin!=keysEnd)
+    {
+        std::size_t count=0;
+        for (;keysBegin!=keysEnd && count<CHUNK;++keysBegin, ++count)
+            keys[count]=&*keysBegin;
+        findInterleaved(trees, keys, results, count);
+        for (std::size_t i=0;i<count;i++)
+            *out++=results[i];
+    }
+    return out;
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    ConstIterator iter;
+    iter.item=lookupItem(key);
     iter.tree=this;
     return iter;
   }
@@ -266,27 +494,17 @@ public:
   iterator find(const key_type& key)
   {
     Iterator iter;
-    Item * item = root;
-    if (root)
-    {
-    while (item->para->first!=key)
-        {
-            if (key>item->para->first)
-                item=item->right;
-            else
-                item=item->left;
-            if (item == nullptr)
-                return end();
-        }
-    }
-    iter.item=item;
+    iter.item=lookupItem(key);
     iter.tree=this;
     return iter;
   }
 
   void remove(const key_type& key)
   {
-    auto iter = find(key);
+    std::size_t visited=0;
+    ConstIterator iter;
+    iter.item=findItem(key, visited);
+    iter.tree=this;
     remove (iter);
   }
 
@@ -314,6 +532,7 @@ public:
             to_delete->parent->right = child;
         delete to_delete;
         size--;
+        Stats::recordErase();
         return;
     }
     else
@@ -321,8 +540,8 @@ public:
         Iterator iter = (Iterator)it;
         iter++;
         to_delete=iter.item;
-        item->para = to_delete->para;
-        to_delete->para = nullptr;
+        // the successor's node goes, taking the removed pair with it
+        std::swap(item->para, to_delete->para);
         remove(iter);
     }
   }
@@ -332,6 +551,88 @@ public:
     return size;
   }
 
+  // Hits, misses, inserts, erases and probes since construction or the
+  // last resetCounters(); all zero unless Stats counts them.
+  MapCounters counters() const
+  {
+    return Stats::readCounters();
+  }
+
+  void resetCounters()
+  {
+    Stats::resetCounters();
+  }
+
+  // Walks the whole tree once, through parent pointers rather than
+  // recursion, so it is safe on degenerate trees; O(n) time and O(height)
+  // extra memory.
+  TreeStats stats() const
+  {
+    TreeStats stats;
+    stats.size=size;
+    stats.height=0;
+    stats.maxDepth=0;
+    stats.averageDepth=0.0;
+    stats.unbalancedNodes=0;
+    stats.nodeBytes=size*(sizeof(Item)+sizeof(value_type));
+    // subtree heights of the nodes on the current path, by depth
+    std::vector<std::size_t> leftHeight;
+    std::vector<std::size_t> rightHeight;
+    std::size_t depthSum=0;
+    std::size_t depth=0;
+    const Item * previous=nullptr;
+    const Item * item=root;
+    while (item!=nullptr)
+    {
+        const Item * next;
+        if (previous==item->parent)
+        {
+            // first time here
+            if (depth==stats.depthHistogram.size())
+            {
+                stats.depthHistogram.push_back(0);
+                leftHeight.push_back(0);
+                rightHeight.push_back(0);
+            }
+            stats.depthHistogram[depth]++;
+            depthSum+=depth;
+            leftHeight[depth]=0;
+            rightHeight[depth]=0;
+            next = item->left ? item->left : item->right ? item->right : item->parent;
+        }
+        else if (previous==item->left && item->right!=nullptr)
+            next=item->right;
+        else
+            next=item->parent;
+
+        if (next==item->parent)
+        {
+            // both subtrees done
+            long balance=static_cast<long>(rightHeight[depth])-static_cast<long>(leftHeight[depth]);
+            stats.balanceFactors[balance]++;
+            if (balance<-1 || balance>1)
+                stats.unbalancedNodes++;
+            std::size_t height=1+std::max(leftHeight[depth], rightHeight[depth]);
+            if (depth>0)
+            {
+                if (item==item->parent->left)
+                    leftHeight[depth-1]=height;
+                else
+                    rightHeight[depth-1]=height;
+            }
+            depth--;
+        }
+        else
+            depth++;
+        previous=item;
+        item=next;
+    }
+    stats.height=stats.depthHistogram.size();
+    stats.maxDepth=stats.height ? stats.height-1 : 0;
+    stats.averageDepth=size ? static_cast<double>(depthSum)/size : 0.0;
+    return stats;
+  }
+
   bool operator==(const TreeMap& other) const
   {
     if (this->size != other.size)
@@ -396,8 +697,8 @@ public:
   }
 };
 
-template <typename KeyType, typename ValueType>
-class TreeMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename Stats>
+class TreeMap<KeyType, ValueType, Stats>::ConstIterator
 {
 private:
   Item * item;
@@ -421,6 +722,13 @@ public:
     tree=other.tree;
   }
 
+  ConstIterator& operator=(const ConstIterator& other)
+  {
+    item=other.item;
+    tree=other.tree;
+    return *this;
+  }
+
   ConstIterator& operator++()
   {
     Item * item=this->item;
@@ -513,8 +821,8 @@ public:
   }
 };
 
-template <typename KeyType, typename ValueType>
-class TreeMap<KeyType, ValueType>::Iterator : public TreeMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename Stats>
+class TreeMap<KeyType, ValueType, Stats>::Iterator : public TreeMap<KeyType, ValueType, Stats>::ConstIterator
 {
 public:
   using reference = typename TreeMap::reference;
@@ -0,0 +1,201 @@
+#ifndef AISDI_MAPS_WORKLOADS_H
+#define AISDI_MAPS_WORKLOADS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace aisdi
+{
+namespace benchmark
+{
+
+using WorkloadKey = std::uint64_t;
+
+// Keys of one benchmark scenario. keys is the insertion order, lookups the
+// probe sequence for find/findMany, removals the order for remove (every
+// key exactly once) and misses as many keys that are not in keys. All of
+// them are reproducible from the seed.
+template <typename Key>
+struct BasicWorkload
+{
+  std::vector<Key> keys;
+  std::vector<Key> lookups;
+  std::vector<Key> removals;
+  std::vector<Key> misses;
+};
+
+using Workload = BasicWorkload<WorkloadKey>;
+
+struct WorkloadOptions
+{
+  // Zipf exponent for the "zipf" lookups; must not be 1.
+  double zipfTheta;
+  // Distance between "strided" keys; the HashMap bucket count by default,
+  // so every key lands in the same bucket.
+  std::uint64_t stride;
+  // Consecutive keys per "clustered" run.
+  std::size_t clusterSize;
+
+  WorkloadOptions() : zipfTheta(0.99), stride(50), clusterSize(64)
+  {}
+};
+
+// splitmix64 finalizer: a bijection, so distinct inputs give distinct keys
+inline WorkloadKey mixKey(std::uint64_t x)
+{
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+  return x ^ (x >> 31);
+}
+
+inline std::vector<WorkloadKey> shuffledKeys(std::vector<WorkloadKey> keys, std::uint64_t seed)
+{
+  std::mt19937_64 generator(seed);
+  std::shuffle(keys.begin(), keys.end(), generator);
+  return keys;
+}
+
+// Zipfian ranks in [0, n), rank 0 being the most popular, using the
+// constant-time method of Gray et al. ("Quickly generating billion-record
+// synthetic databases"), as in YCSB. Setup is O(n).
+class ZipfGenerator
+{
+private:
+  std::size_t n;
+  double theta;
+  double zetan;
+  double alpha;
+  double eta;
+  std::mt19937_64 generator;
+  std::uniform_real_distribution<double> uniform;
+
+public:
+  ZipfGenerator(std::size_t n, double theta, std::uint64_t seed)
+    : n(n), theta(theta), zetan(0), generator(seed), uniform(0.0, 1.0)
+  {
+    if (theta <= 0 || theta == 1.0)
+        throw std::invalid_argument("zipf theta must be positive and not 1");
+    for (std::size_t i = 1; i <= n; i++)
+        zetan += 1.0 / std::pow(static_cast<double>(i), theta);
+    double zeta2 = 1.0 + 1.0 / std::pow(2.0, theta);
+    alpha = 1.0 / (1.0 - theta);
+    eta = (1.0 - std::pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / zetan);
+  }
+
+  std::size_t operator()()
+  {
+    double u = uniform(generator);
+    double uz = u * zetan;
+    if (uz < 1.0 || n < 2)
+        return 0;
+    if (uz < 1.0 + std::pow(0.5, theta))
+        return 1;
+    std::size_t rank = static_cast<std::size_t>(n * std::pow(eta * u - eta + 1.0, alpha));
+    return std::min(rank, n - 1);
+  }
+};
+
+// The distributions makeWorkload knows, described below.
+inline const std::vector<std::string>& workloadDistributions()
+{
+  static const std::vector<std::string> names =
+    { "random", "sequential", "reverse", "zipf", "clustered", "strided" };
+  return names;
+}
+
+// Generates count distinct keys laid out by distribution:
+//   random     - uniformly spread 64-bit keys, random order
+//   sequential - 0, 1, 2, ... in ascending order (degenerate for TreeMap)
+//   reverse    - the same keys in descending order
+//   zipf       - random keys, lookups skewed towards a few hot keys
+//   clustered  - runs of clusterSize consecutive keys, runs far apart
+//   strided    - multiples of stride in random order (one HashMap bucket)
+inline Workload makeWorkload(const std::string& distribution, std::size_t count,
+                             std::uint64_t seed, const WorkloadOptions& options = WorkloadOptions())
+{
+  Workload workload;
+  std::vector<WorkloadKey>& keys = workload.keys;
+  keys.resize(count);
+  if (distribution == "random" || distribution == "zipf")
+  {
+    for (std::size_t i = 0; i < count; i++)
+        keys[i] = mixKey(seed * 0x9E3779B97F4A7C15ull + i);
+  }
+  else if (distribution == "sequential")
+  {
+    for (std::size_t i = 0; i < count; i++)
+        keys[i] = i;
+  }
+  else if (distribution == "reverse")
+  {
+    for (std::size_t i = 0; i < count; i++)
+        keys[i] = count - 1 - i;
+  }
+  else if (distribution == "clustered")
+  {
+    // clusters are spread 1024 cluster widths apart and inserted in random
+    // cluster order, keys inside a cluster stay consecutive
+    std::size_t clusterSize = std::max<std::size_t>(1, options.clusterSize);
+    std::vector<WorkloadKey> clusters((count + clusterSize - 1) / clusterSize);
+    for (std::size_t c = 0; c < clusters.size(); c++)
+        clusters[c] = c * clusterSize * 1024;
+    clusters = shuffledKeys(clusters, seed);
+    for (std::size_t i = 0; i < count; i++)
+        keys[i] = clusters[i / clusterSize] + i % clusterSize;
+  }
+  else if (distribution == "strided")
+  {
+    for (std::size_t i = 0; i < count; i++)
+        keys[i] = i * options.stride;
+    keys = shuffledKeys(keys, seed);
+  }
+  else
+    throw std::invalid_argument("unknown distribution: " + distribution);
+
+  workload.removals = shuffledKeys(keys, seed + 1);
+  if (distribution == "zipf" && count > 0)
+  {
+    ZipfGenerator zipf(count, options.zipfTheta, seed + 2);
+    workload.lookups.resize(count);
+    for (std::size_t i = 0; i < count; i++)
+        workload.lookups[i] = keys[zipf()];
+  }
+  else
+    workload.lookups = shuffledKeys(keys, seed + 2);
+
+  // random 64-bit keys, skipping the (unlikely) ones that are present
+  std::vector<WorkloadKey> sorted(keys);
+  std::sort(sorted.begin(), sorted.end());
+  workload.misses.reserve(count);
+  for (std::uint64_t i = 0; workload.misses.size() < count; i++)
+  {
+    WorkloadKey key = mixKey((seed + 3) * 0xD1B54A32D192ED03ull + i);
+    if (!std::binary_search(sorted.begin(), sorted.end(), key))
+        workload.misses.push_back(key);
+  }
+  return workload;
+}
+
+// The same workload with every key converted to Key, e.g. an
+// InstrumentedKey.
+template <typename Key>
+BasicWorkload<Key> convertWorkload(const Workload& workload)
+{
+  BasicWorkload<Key> converted;
+  converted.keys.assign(workload.keys.begin(), workload.keys.end());
+  converted.lookups.assign(workload.lookups.begin(), workload.lookups.end());
+  converted.removals.assign(workload.removals.begin(), workload.removals.end());
+  converted.misses.assign(workload.misses.begin(), workload.misses.end());
+  return converted;
+}
+
+}
+}
+
+#endif /* AISDI_MAPS_WORKLOADS_H */
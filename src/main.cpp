@@ -1,65 +1,593 @@
+#include <algorithm>
 #include <cstddef>
-#include <cstdlib>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
+#include "Benchmark.h"
+#include "BenchmarkReport.h"
+#include "InstrumentedKey.h"
+#include "MemoryUsage.h"
+#include "Trace.h"
 #include "TreeMap.h"
 #include "HashMap.h"
 
+namespace
+{
+
+namespace bench = aisdi::benchmark;
+
+using Key = bench::WorkloadKey;
+using Value = std::uint64_t;
+// keys of the --instrumented runs
+using CountedKey = aisdi::InstrumentedKey<Key>;
 
+// keeps the compiler from dropping lookups whose results are never used
+volatile std::uint64_t sink;
+
+template <typename Map, typename K>
+void fill(Map& map, const std::vector<K>& keys)
+{
+    for (std::size_t i = 0; i < keys.size(); i++)
+        map[keys[i]] = i;
+}
 
-int main()
+// Gives every benchmarked container the same lookup, removal and batched
+// lookup interface; operator[], copying and iteration are common already.
+template <typename Map>
+struct MapAccess
 {
-    srand (time(NULL));
-    aisdi::HashMap<int,char> hashmap;
-    aisdi::TreeMap<int,char> tree;
+    using K = typename Map::key_type;
+
+    // whether the map reports the tree nodes its searches visit
+    static const bool countsVisits = true;
+
+    static const Value * lookup(const Map& map, const K& key)
+    {
+        return map.tryGet(key);
+    }
+
+    static void remove(Map& map, const K& key)
+    {
+        map.remove(key);
+    }
+
+    // remove() for keys that may be missing
+    static void erase(Map& map, const K& key)
+    {
+        auto it = map.find(key);
+        if (it != map.end())
+            map.remove(it);
+    }
+
+    template <typename InputIt, typename OutputIt>
+    static void lookupMany(const Map& map, InputIt first, InputIt last, OutputIt out)
+    {
+        map.findMany(first, last, out);
+    }
+};
 
-    clock_t czas=clock();
+// The standard containers have no batched lookup, so findMany measures
+// a plain loop of finds for them.
+template <typename Map>
+struct StandardMapAccess
+{
+    using K = typename Map::key_type;
 
-    int tab[10000];
+    static const bool countsVisits = false;
 
-    for (int i=0; i<10000; i++)
+    static const Value * lookup(const Map& map, const K& key)
     {
-        tab[i]=rand();
+        auto it = map.find(key);
+        return it == map.end() ? nullptr : &it->second;
     }
 
-    for (int i=0; i<10000; i++)
+    static void remove(Map& map, const K& key)
     {
-        hashmap[tab[i]]='A'+(rand()%26);
+        map.erase(key);
     }
-    std::cout << "Dodawanie nowych elementow do struktury HashMap trwalo " << clock()-czas << std::endl;
 
-    czas=clock();
-    for (int i=0; i<10000; i++)
+    static void erase(Map& map, const K& key)
     {
-        tree[tab[i]]='A'+(rand()%26);
+        map.erase(key);
     }
-    std::cout << "Dodawanie nowych elementow do struktury TreeMap trwalo " << clock()-czas << std::endl;
 
-    czas=clock();
-    for (int i=0; i<10000; i++)
+    template <typename InputIt, typename OutputIt>
+    static void lookupMany(const Map& map, InputIt first, InputIt last, OutputIt out)
     {
-        hashmap.valueOf(tab[i]);
+        for (; first != last; ++first, ++out)
+            *out = lookup(map, *first);
     }
-    std::cout << "Odnajdywanie wartości po kluczu w strukturze HashMap trwalo " << clock()-czas << std::endl;
+};
+
+template <typename K>
+struct MapAccess<std::map<K, Value>> : StandardMapAccess<std::map<K, Value>>
+{};
+
+template <typename K>
+struct MapAccess<std::unordered_map<K, Value>> : StandardMapAccess<std::unordered_map<K, Value>>
+{};
+
+template <typename Map>
+void recordShape(const Map&, bench::Result&)
+{}
+
+template <typename K>
+void recordShape(const aisdi::TreeMap<K, Value>& map, bench::Result& result)
+{
+    aisdi::TreeStats stats = map.stats();
+    result.treeHeight = static_cast<double>(stats.height);
+    result.averageDepth = stats.averageDepth;
+}
 
-    czas=clock();
-    for (int i=0; i<10000; i++)
+// Runs warmup + repetitions of one operation over the workload's keys.
+template <typename Map>
+bench::Result runScenario(const std::string& operation, const std::string& mapName,
+                          const std::string& distribution,
+                          const bench::BasicWorkload<typename Map::key_type>& workload,
+                          const bench::Options& options)
+{
+    using Access = MapAccess<Map>;
+    using K = typename Map::key_type;
+    const std::vector<K>& keys = workload.keys;
+    const std::vector<K>& lookups = workload.lookups;
+    const std::vector<K>& removals = workload.removals;
+    const std::vector<K>& misses = workload.misses;
+    const std::size_t n = keys.size();
+    bench::Samples samples;
+    std::uint64_t checksum = 0;
+    // filled for every operation, so that its footprint can be reported
+    bench::AllocationStats heapBefore = bench::allocationStats();
+    Map lookupMap;
+    fill(lookupMap, keys);
+    std::size_t footprint = (bench::allocationStats() - heapBefore).liveBytes();
+
+    for (unsigned int run = 0; run < options.warmup + options.repetitions; run++)
     {
-        tree.valueOf(tab[i]);
+        bench::Samples warmup;
+        bench::Samples& target = run < options.warmup ? warmup : samples;
+        if (operation == "insert")
+        {
+            Map map;
+            bench::timeBatches(n, options.batch, target, [&](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t i = begin; i < end; i++)
+                    map[keys[i]] = i;
+            });
+        }
+        else if (operation == "find" || operation == "findMiss")
+        {
+            const std::vector<K>& probes = operation == "find" ? lookups : misses;
+            bench::timeBatches(n, options.batch, target, [&](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t i = begin; i < end; i++)
+                    if (const Value * value = Access::lookup(lookupMap, probes[i]))
+                        checksum += *value;
+            });
+        }
+        else if (operation == "findMany")
+        {
+            std::vector<const Value*> found(options.batch);
+            bench::timeBatches(n, options.batch, target, [&](std::size_t begin, std::size_t end)
+            {
+                Access::lookupMany(lookupMap, lookups.begin() + begin, lookups.begin() + end,
+                                   found.begin());
+                checksum += (found[0] != nullptr);
+            });
+        }
+        else if (operation == "remove")
+        {
+            Map map;
+            fill(map, keys);
+            bench::timeBatches(n, options.batch, target, [&](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t i = begin; i < end; i++)
+                    Access::remove(map, removals[i]);
+            });
+        }
+        else if (operation == "iterate")
+        {
+            // one sample per full pass, ns/op is per visited item
+            const Map& map = lookupMap;
+            bench::timeBatches(n, n, target, [&](std::size_t, std::size_t)
+            {
+                for (const auto& item : map)
+                    checksum += item.second;
+            });
+        }
+        else if (operation == "copy")
+        {
+            // one sample per copy of the whole map, ns/op is per copied item;
+            // the previous copy is freed before the clock starts
+            std::unique_ptr<Map> copy;
+            bench::timeBatches(n, n, target, [&](std::size_t, std::size_t)
+            {
+                copy.reset(new Map(lookupMap));
+            });
+            checksum += copy && copy->begin() != copy->end();
+        }
+        else
+            throw std::invalid_argument("unknown operation: " + operation);
     }
-    std::cout << "Odnajdywanie wartości po kluczu w strukturze TreeMap trwalo  " << clock()-czas << std::endl;
+    sink = checksum;
+    bench::Result result = bench::summarize(operation, mapName, distribution, n, options.repetitions,
+                                            samples, n ? static_cast<double>(footprint) / n : 0.0);
+    if (!std::is_same<K, CountedKey>::value)
+        result.comparisonsPerOp = result.hashesPerOp = -1.0;
+    if (!std::is_same<K, CountedKey>::value || !Access::countsVisits)
+        result.visitsPerOp = -1.0;
+    recordShape(lookupMap, result);
+    return result;
+}
 
-    czas=clock();
-    for (int i=0; i<10000; i++)
+// K is Key, or CountedKey for --instrumented runs.
+template <typename K>
+bench::Result run(const std::string& operation, const std::string& mapName,
+                  const std::string& distribution, const bench::BasicWorkload<K>& workload,
+                  const bench::Options& options)
+{
+    if (mapName == "tree")
+        return runScenario<aisdi::TreeMap<K, Value>>(operation, mapName, distribution, workload, options);
+    if (mapName == "hash")
+        return runScenario<aisdi::HashMap<K, Value>>(operation, mapName, distribution, workload, options);
+    if (mapName == "hash-pow2")
+        return runScenario<aisdi::HashMap<K, Value, aisdi::NoStats, aisdi::PowerOfTwoBuckets<64>>>(
+            operation, mapName, distribution, workload, options);
+    if (mapName == "hash-fastrange")
+        return runScenario<aisdi::HashMap<K, Value, aisdi::NoStats, aisdi::FastRangeBuckets<50>>>(
+            operation, mapName, distribution, workload, options);
+    if (mapName == "hash-prime")
+        return runScenario<aisdi::HashMap<K, Value, aisdi::NoStats, aisdi::PrimeBuckets<53>>>(
+            operation, mapName, distribution, workload, options);
+    if (mapName == "stdmap")
+        return runScenario<std::map<K, Value>>(operation, mapName, distribution, workload, options);
+    if (mapName == "unordered")
+        return runScenario<std::unordered_map<K, Value>>(operation, mapName, distribution, workload, options);
+    throw std::invalid_argument("unknown map: " + mapName);
+}
+
+// Runs the whole trace against a fresh map per repetition, timing it in
+// slices of options.batch operations.
+template <typename Map>
+bench::Result runReplay(const std::string& mapName, const std::vector<aisdi::TraceEntry>& trace,
+                        const bench::Options& options)
+{
+    using Access = MapAccess<Map>;
+    using aisdi::TraceEntry;
+    bench::Samples samples;
+    std::uint64_t checksum = 0;
+    double bytesPerEntry = 0.0;
+    for (unsigned int run = 0; run < options.warmup + options.repetitions; run++)
     {
-        hashmap.remove(tab[i]);
+        bench::Samples warmup;
+        bench::Samples& target = run < options.warmup ? warmup : samples;
+        bench::AllocationStats heapBefore = bench::allocationStats();
+        Map map;
+        const Map& constMap = map;
+        bench::timeBatches(trace.size(), options.batch, target, [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                const TraceEntry& entry = trace[i];
+                const Key key = static_cast<Key>(entry.key);
+                switch (entry.operation)
+                {
+                case TraceEntry::Insert:
+                    map[key] = i;
+                    break;
+                case TraceEntry::Lookup:
+                    if (const Value * value = Access::lookup(map, key))
+                        checksum += *value;
+                    break;
+                case TraceEntry::Remove:
+                    Access::erase(map, key);
+                    break;
+                case TraceEntry::Iterate:
+                    for (const auto& item : constMap)
+                        checksum += item.second;
+                    break;
+                case TraceEntry::Range:
+                {
+                    auto it = constMap.find(key);
+                    for (std::uint64_t n = 0; n < entry.count && it != constMap.end(); n++, ++it)
+                        checksum += it->second;
+                    break;
+                }
+                case TraceEntry::Clear:
+                    map.clear();
+                    break;
+                }
+            }
+        });
+        std::size_t entries = 0;
+        for (auto it = constMap.begin(); it != constMap.end(); ++it)
+            entries++;
+        std::size_t bytes = (bench::allocationStats() - heapBefore).liveBytes();
+        bytesPerEntry = entries ? static_cast<double>(bytes) / entries : 0.0;
     }
-    std::cout << "Usuwanie elementow ze struktury HashMap trwalo " << clock()-czas << std::endl;
+    sink = checksum;
+    bench::Result result = bench::summarize("replay", mapName, "trace", trace.size(),
+                                            options.repetitions, samples, bytesPerEntry);
+    result.comparisonsPerOp = result.hashesPerOp = result.visitsPerOp = -1.0;
+    return result;
+}
 
-    czas=clock();
-    for (int i=0; i<10000; i++)
+bench::Result replay(const std::string& mapName, const std::vector<aisdi::TraceEntry>& trace,
+                     const bench::Options& options)
+{
+    if (mapName == "tree")
+        return runReplay<aisdi::TreeMap<Key, Value>>(mapName, trace, options);
+    if (mapName == "hash")
+        return runReplay<aisdi::HashMap<Key, Value>>(mapName, trace, options);
+    if (mapName == "stdmap")
+        return runReplay<std::map<Key, Value>>(mapName, trace, options);
+    if (mapName == "unordered")
+        return runReplay<std::unordered_map<Key, Value>>(mapName, trace, options);
+    throw std::invalid_argument("unknown map: " + mapName);
+}
+
+// Writes a trace of the first distribution and size: every key inserted,
+// looked up (hits, then misses), a short range after every 64th lookup,
+// one full iteration and every key removed again.
+std::uint64_t record(const std::string& path, const bench::Options& options)
+{
+    const bench::Workload workload = bench::makeWorkload(options.distributions.at(0),
+                                                         options.sizes.at(0), options.seed,
+                                                         options.workload);
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        throw std::invalid_argument("cannot write " + path);
+    aisdi::TraceRecorder<aisdi::HashMap<Key, Value>> map(file);
+    std::uint64_t checksum = 0;
+    for (std::size_t i = 0; i < workload.keys.size(); i++)
+        map[workload.keys[i]] = i;
+    for (std::size_t i = 0; i < workload.lookups.size(); i++)
     {
-        tree.remove(tab[i]);
+        if (const Value * value = map.tryGet(workload.lookups[i]))
+            checksum += *value;
+        if (i % 64 == 0)
+            map.forRange(workload.lookups[i], 16, [&](const std::pair<const Key, Value>& item)
+            {
+                checksum += item.second;
+            });
     }
-    std::cout << "Usuwanie elementow ze struktury TreeMap trwalo " << clock()-czas << std::endl;
+    for (Key key : workload.misses)
+        checksum += map.contains(key);
+    for (const auto& item : map)
+        checksum += item.second;
+    for (Key key : workload.removals)
+        map.remove(key);
+    sink = checksum;
+    map.flush();
+    return map.getRecorded();
+}
+
+// Keeps liveSize random keys in the map for options.churnRounds rounds,
+// each replacing options.churnOps randomly chosen keys with fresh ones,
+// and samples memory use and iteration speed after every round.
+template <typename Map>
+void runChurn(const std::string& mapName, std::size_t liveSize, const bench::Options& options,
+              std::vector<bench::ChurnSample>& samples, std::ostream * table)
+{
+    using Access = MapAccess<Map>;
+    // so that this run inherits as little as possible of the previous one
+    bench::releaseFreeMemory();
+    std::uint64_t nextKey = 0;
+    auto freshKey = [&]() { return bench::mixKey(options.seed * 0x9E3779B97F4A7C15ull + nextKey++); };
+    std::vector<Key> live(liveSize);
+    for (std::size_t i = 0; i < liveSize; i++)
+        live[i] = freshKey();
+    std::mt19937_64 victims(options.seed + 4);
+    const std::size_t opsPerRound = options.churnOps ? options.churnOps : liveSize;
+    std::uint64_t checksum = 0;
+
+    bench::AllocationStats heapBefore = bench::allocationStats();
+    Map map;
+    fill(map, live);
+    for (unsigned int round = 0; round <= options.churnRounds; round++)
+    {
+        bench::ChurnSample sample;
+        sample.map = mapName;
+        sample.liveSize = liveSize;
+        sample.round = round;
+        sample.operations = round * opsPerRound;
+        sample.churnNsPerOp = 0.0;
+        if (round > 0 && liveSize > 0)
+        {
+            bench::Clock::time_point start = bench::Clock::now();
+            for (std::size_t i = 0; i < opsPerRound; i++)
+            {
+                Key& slot = live[victims() % liveSize];
+                Access::remove(map, slot);
+                slot = freshKey();
+                map[slot] = i;
+            }
+            sample.churnNsPerOp = std::chrono::duration<double, std::nano>(
+                bench::Clock::now() - start).count() / opsPerRound;
+        }
+
+        const Map& constMap = map;
+        bench::Clock::time_point start = bench::Clock::now();
+        for (const auto& item : constMap)
+            checksum += item.second;
+        double iterateNs = std::chrono::duration<double, std::nano>(bench::Clock::now() - start).count();
+        sample.iterateNsPerEntry = liveSize ? iterateNs / liveSize : 0.0;
+
+        bench::HeapUsage heap = bench::heapUsage();
+        sample.residentBytes = bench::residentBytes();
+        sample.heapInUse = heap.inUse;
+        sample.heapReserved = heap.reserved;
+        std::size_t mapBytes = (bench::allocationStats() - heapBefore).liveBytes();
+        sample.bytesPerEntry = liveSize ? static_cast<double>(mapBytes) / liveSize : 0.0;
+        samples.push_back(sample);
+        if (table)
+            bench::printChurnSample(*table, sample);
+    }
+    sink = checksum;
+}
+
+void churn(const std::string& mapName, std::size_t liveSize, const bench::Options& options,
+           std::vector<bench::ChurnSample>& samples, std::ostream * table)
+{
+    if (mapName == "tree")
+        runChurn<aisdi::TreeMap<Key, Value>>(mapName, liveSize, options, samples, table);
+    else if (mapName == "hash")
+        runChurn<aisdi::HashMap<Key, Value>>(mapName, liveSize, options, samples, table);
+    else if (mapName == "stdmap")
+        runChurn<std::map<Key, Value>>(mapName, liveSize, options, samples, table);
+    else if (mapName == "unordered")
+        runChurn<std::unordered_map<Key, Value>>(mapName, liveSize, options, samples, table);
+    else
+        throw std::invalid_argument("unknown map: " + mapName);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::string(argv[i]) == "--help")
+        {
+            bench::printUsage(std::cout, argv[0]);
+            return 0;
+        }
+    }
+
+    bench::Options options;
+    std::vector<bench::Result> baseline;
+    std::vector<aisdi::TraceEntry> trace;
+    try
+    {
+        options = bench::parseOptions(argc, argv);
+        if (!options.baseline.empty())
+        {
+            std::ifstream baselineFile(options.baseline);
+            if (!baselineFile)
+                throw std::invalid_argument("cannot read baseline " + options.baseline);
+            baseline = bench::readCsv(baselineFile);
+        }
+        if (!options.replay.empty())
+        {
+            std::ifstream traceFile(options.replay, std::ios::binary);
+            if (!traceFile)
+                throw std::invalid_argument("cannot read trace " + options.replay);
+            trace = aisdi::readTrace(traceFile);
+        }
+        if (!options.record.empty())
+        {
+            std::uint64_t entries = record(options.record, options);
+            std::cerr << "recorded " << entries << " operations to " << options.record << std::endl;
+            return 0;
+        }
+    }
+    catch (const std::invalid_argument& error)
+    {
+        std::cerr << error.what() << std::endl;
+        bench::printUsage(std::cerr, argv[0]);
+        return 1;
+    }
+
+    std::ofstream outputFile;
+    if (!options.output.empty())
+    {
+        outputFile.open(options.output);
+        if (!outputFile)
+        {
+            std::cerr << "cannot write " << options.output << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = options.output.empty() ? std::cout : outputFile;
+
+    if (options.churn)
+    {
+        std::vector<bench::ChurnSample> samples;
+        std::ostream * table = options.format == "table" ? &out : nullptr;
+        if (table)
+            bench::printChurnHeader(out);
+        for (std::size_t size : options.sizes)
+            for (const std::string& mapName : options.maps)
+                churn(mapName, size, options, samples, table);
+        if (table)
+            bench::printChurnSummary(out, samples);
+        else if (options.format == "csv")
+            bench::writeChurnCsv(out, samples);
+        else
+            bench::writeChurnJson(out, samples);
+        return 0;
+    }
+
+    bench::PerfCounters& counters = bench::PerfCounters::process();
+    if (!options.counters)
+        counters.close();
+    else if (!counters.available())
+        std::cerr << "hardware counters unavailable, reporting times only" << std::endl;
+
+    // the table is printed as results come in, csv and json at the end
+    std::vector<bench::Result> results;
+    if (options.format == "table")
+        bench::printHeader(out, counters.available(), options.instrumented, options.batch);
+    // all maps of one scenario run before it is reported, so that their
+    // speedups over the standard containers are known
+    auto report = [&](std::vector<bench::Result>& scenario)
+    {
+        bench::assignSpeedups(scenario);
+        for (const bench::Result& result : scenario)
+        {
+            results.push_back(result);
+            if (options.format == "table")
+                bench::printResult(out, result, counters.available(), options.instrumented);
+        }
+    };
+    if (!options.replay.empty())
+    {
+        std::vector<bench::Result> scenario;
+        for (const std::string& mapName : options.maps)
+            scenario.push_back(replay(mapName, trace, options));
+        report(scenario);
+    }
+    for (const std::string& distribution : options.replay.empty() ? options.distributions
+                                                                  : std::vector<std::string>())
+    {
+        for (std::size_t size : options.sizes)
+        {
+            const bench::Workload workload =
+                bench::makeWorkload(distribution, size, options.seed, options.workload);
+            if (options.shape && options.format == "table")
+            {
+                aisdi::TreeMap<Key, Value> tree;
+                fill(tree, workload.keys);
+                bench::printTreeStats(out, distribution, tree.stats());
+            }
+            const bench::BasicWorkload<CountedKey> countedWorkload = options.instrumented
+                ? bench::convertWorkload<CountedKey>(workload) : bench::BasicWorkload<CountedKey>();
+            for (const std::string& operation : options.operations)
+            {
+                std::vector<bench::Result> scenario;
+                for (const std::string& mapName : options.maps)
+                    scenario.push_back(options.instrumented
+                        ? run(operation, mapName, distribution, countedWorkload, options)
+                        : run(operation, mapName, distribution, workload, options));
+                report(scenario);
+            }
+        }
+    }
+    if (options.format == "csv")
+        bench::writeCsv(out, results);
+    else if (options.format == "json")
+        bench::writeJson(out, results);
+
+    if (!options.baseline.empty()
+        && bench::compareWithBaseline(std::cerr, baseline, results, options.threshold))
+        return 2;
+    return 0;
 }
@@ -0,0 +1,80 @@
+#include <BucketPolicy.h>
+#include <HashMap.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using BucketPolicies = boost::mpl::list<aisdi::ModuloBuckets<50>, aisdi::PowerOfTwoBuckets<64>,
+                                        aisdi::FastRangeBuckets<50>, aisdi::PrimeBuckets<53>>;
+
+BOOST_AUTO_TEST_SUITE(BucketPolicyTests)
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenAnyHash_WhenIndexing_ThenBucketIsInRange,
+                              Buckets,
+                              BucketPolicies)
+{
+  std::mt19937_64 random(2016);
+  for (int i = 0; i < 10000; i++)
+    BOOST_REQUIRE_LT(Buckets::index(random()), Buckets::COUNT);
+  BOOST_CHECK_LT(Buckets::index(0), Buckets::COUNT);
+  BOOST_CHECK_LT(Buckets::index(UINT64_MAX), Buckets::COUNT);
+}
+
+BOOST_AUTO_TEST_CASE(Given32BitHash_WhenIndexingByPrime_ThenResultIsRemainder)
+{
+  std::mt19937 random(2016);
+  for (int i = 0; i < 10000; i++)
+  {
+    std::uint32_t hash = random();
+    BOOST_REQUIRE_EQUAL(aisdi::PrimeBuckets<53>::index(hash), hash % 53);
+    BOOST_REQUIRE_EQUAL(aisdi::PrimeBuckets<1000003>::index(hash), hash % 1000003);
+  }
+  BOOST_CHECK_EQUAL(aisdi::PrimeBuckets<53>::index(UINT32_MAX), UINT32_MAX % 53);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenBucketPolicy_WhenFillingHashMap_ThenEveryKeyIsFound,
+                              Buckets,
+                              BucketPolicies)
+{
+  aisdi::HashMap<std::int32_t, std::string, aisdi::NoStats, Buckets> map;
+  static_assert(decltype(map)::bucketCount() == Buckets::COUNT, "bucket count is a constant");
+  for (std::int32_t key = 0; key < 1000; key++)
+    map[key * 7] = std::to_string(key);
+
+  std::size_t iterated = 0;
+  for (auto it = map.begin(); it != map.end(); ++it)
+    iterated++;
+
+  BOOST_CHECK_EQUAL(iterated, 1000u);
+  for (std::int32_t key = 0; key < 1000; key++)
+    BOOST_REQUIRE_EQUAL(map.valueOf(key * 7), std::to_string(key));
+  BOOST_CHECK(!map.contains(1));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSequentialKeys_WhenBucketing_ThenEveryBucketIsUsed,
+                              Buckets,
+                              BucketPolicies)
+{
+  aisdi::HashMap<std::int32_t, std::string, aisdi::NoStats, Buckets> map;
+  for (std::int32_t key = 0; key < 10000; key++)
+    map[key] = "";
+
+  BOOST_CHECK_EQUAL(map.bucketStats().occupiedBuckets, Buckets::COUNT);
+  BOOST_CHECK_LT(map.bucketStats().uniformityZ(), 3.0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNegativeKey_WhenUsingDefaultBuckets_ThenItIsStoredAndFound)
+{
+  aisdi::HashMap<std::int32_t, std::string> map;
+  map[-42] = "Alice";
+
+  BOOST_CHECK_LT(map.bucketOf(-42), map.bucketCount());
+  BOOST_CHECK_EQUAL(map.valueOf(-42), "Alice");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,234 @@
+#include <TreeMap.h>
+#include <HashMap.h>
+#include <InstrumentedKey.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+// Checks how the cost of map operations grows with the map size, so that
+// an accidentally quadratic change fails here instead of in production.
+// Lookups, inserts and copies are measured in key comparisons, which are
+// exact and the same on every machine. Iteration and teardown do no
+// comparisons; they are timed, best of several runs, with bounds several
+// times looser than the expected growth.
+
+namespace
+{
+
+using CountedKey = aisdi::InstrumentedKey<std::uint64_t>;
+
+std::vector<std::size_t> doublingSizes()
+{
+  return { 1u << 10, 1u << 11, 1u << 12, 1u << 13, 1u << 14, 1u << 15, 1u << 16 };
+}
+
+// Timed maps stay small enough for the whole map to be in cache at every
+// size; past that, cache misses alone make time per item grow many times.
+std::vector<std::size_t> timedSizes()
+{
+  return { 1u << 8, 1u << 9, 1u << 10, 1u << 11, 1u << 12, 1u << 13 };
+}
+
+std::vector<std::uint64_t> randomKeys(std::size_t count)
+{
+  std::mt19937_64 generator(2016);
+  std::vector<std::uint64_t> keys(count);
+  for (std::uint64_t& key : keys)
+    key = generator();
+  return keys;
+}
+
+template <typename Map>
+void fill(Map& map, const std::vector<std::uint64_t>& keys)
+{
+  for (std::size_t i = 0; i < keys.size(); i++)
+    map[keys[i]] = i;
+}
+
+const int RUNS = 15;
+
+template <typename Body>
+double fastestSeconds(Body body)
+{
+  double best = 1e9;
+  for (int run = 0; run < RUNS; run++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+// Expected cost per operation is about c * log2(n) for a randomly built
+// binary search tree (average depth 1.39 log2 n, two comparisons a level).
+void thenGrowthIsLogarithmic(const std::vector<std::size_t>& sizes,
+                             const std::vector<double>& perOperation)
+{
+  for (std::size_t i = 1; i < sizes.size(); i++)
+  {
+    // one doubling adds one level on average: about 2.8 comparisons
+    BOOST_CHECK_MESSAGE(perOperation[i] - perOperation[i - 1] < 8.0,
+                        "cost per operation jumped from " << perOperation[i - 1]
+                        << " to " << perOperation[i] << " at size " << sizes[i]);
+    BOOST_CHECK_MESSAGE(perOperation[i] < 8.0 * std::log2(sizes[i]),
+                        perOperation[i] << " comparisons per operation at size " << sizes[i]);
+  }
+}
+
+// Expected time per item stays flat; cache misses may make it grow a
+// little, a quadratic algorithm would make it grow with the size ratio.
+void thenGrowthIsLinear(const std::vector<std::size_t>& sizes, const std::vector<double>& perItem)
+{
+  const double ratio = perItem.back() / perItem.front();
+  const double sizeRatio = static_cast<double>(sizes.back()) / sizes.front();
+  BOOST_CHECK_MESSAGE(ratio < sizeRatio / 4,
+                      "time per item grew " << ratio << " times for "
+                      << sizeRatio << " times as many items");
+}
+
+}
+
+using MapTypes = boost::mpl::list<aisdi::TreeMap<CountedKey, std::uint64_t>,
+                                  aisdi::HashMap<CountedKey, std::uint64_t>>;
+
+BOOST_AUTO_TEST_SUITE(ComplexityTests)
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenRandomKeys_WhenLookingUp_ThenComparisonsGrowLogarithmically,
+                              Map,
+                              MapTypes)
+{
+  const std::vector<std::size_t> sizes = doublingSizes();
+  std::vector<double> perLookup;
+  for (std::size_t size : sizes)
+  {
+    const std::vector<std::uint64_t> keys = randomKeys(size);
+    Map map;
+    fill(map, keys);
+
+    aisdi::keyCounters().comparisons = 0;
+    for (std::uint64_t key : keys)
+      BOOST_REQUIRE(map.contains(key));
+    perLookup.push_back(static_cast<double>(aisdi::keyCounters().comparisons) / size);
+  }
+
+  thenGrowthIsLogarithmic(sizes, perLookup);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenRandomKeys_WhenInserting_ThenComparisonsGrowLogarithmically,
+                              Map,
+                              MapTypes)
+{
+  const std::vector<std::size_t> sizes = doublingSizes();
+  std::vector<double> perInsert;
+  for (std::size_t size : sizes)
+  {
+    const std::vector<std::uint64_t> keys = randomKeys(size);
+    Map map;
+
+    aisdi::keyCounters().comparisons = 0;
+    fill(map, keys);
+    perInsert.push_back(static_cast<double>(aisdi::keyCounters().comparisons) / size);
+  }
+
+  thenGrowthIsLogarithmic(sizes, perInsert);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCopying_ThenNoKeysAreCompared,
+                              Map,
+                              MapTypes)
+{
+  for (std::size_t size : doublingSizes())
+  {
+    Map map;
+    fill(map, randomKeys(size));
+
+    aisdi::keyCounters().comparisons = 0;
+    const Map copy(map);
+    BOOST_REQUIRE_EQUAL(aisdi::keyCounters().comparisons, 0u);
+    BOOST_REQUIRE_EQUAL(copy.getSize(), size);
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCopying_ThenTimeGrowsLinearly,
+                              Map,
+                              MapTypes)
+{
+  const std::vector<std::size_t> sizes = timedSizes();
+  std::vector<double> perItem;
+  for (std::size_t size : sizes)
+  {
+    Map map;
+    fill(map, randomKeys(size));
+
+    double seconds = fastestSeconds([&]()
+    {
+      const Map copy(map);
+      BOOST_REQUIRE_EQUAL(copy.getSize(), size);
+    });
+    perItem.push_back(seconds / size);
+  }
+
+  thenGrowthIsLinear(sizes, perItem);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenIterating_ThenTimeGrowsLinearly,
+                              Map,
+                              MapTypes)
+{
+  const std::vector<std::size_t> sizes = timedSizes();
+  std::vector<double> perItem;
+  for (std::size_t size : sizes)
+  {
+    Map map;
+    fill(map, randomKeys(size));
+    const Map& constMap = map;
+
+    std::size_t visited = 0;
+    double seconds = fastestSeconds([&]()
+    {
+      for (auto it = constMap.begin(); it != constMap.end(); ++it)
+        visited++;
+    });
+    BOOST_REQUIRE_EQUAL(visited, RUNS * size);
+    perItem.push_back(seconds / size);
+  }
+
+  thenGrowthIsLinear(sizes, perItem);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenClearing_ThenTimeGrowsLinearly,
+                              Map,
+                              MapTypes)
+{
+  const std::vector<std::size_t> sizes = timedSizes();
+  std::vector<double> perItem;
+  for (std::size_t size : sizes)
+  {
+    const std::vector<std::uint64_t> keys = randomKeys(size);
+    std::vector<Map> maps(RUNS);
+    for (Map& map : maps)
+      fill(map, keys);
+
+    std::size_t next = 0;
+    double seconds = fastestSeconds([&]()
+    {
+      maps[next++].clear();
+    });
+    perItem.push_back(seconds / size);
+  }
+
+  thenGrowthIsLinear(sizes, perItem);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
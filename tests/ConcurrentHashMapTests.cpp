@@ -0,0 +1,190 @@
+#include <ConcurrentHashMap.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+
+template <typename K>
+using Map = aisdi::ConcurrentHashMap<K, std::string>;
+
+namespace
+{
+
+// A value whose assignment throws while failing is set.
+struct Fragile
+{
+  static bool failing;
+  int value;
+
+  Fragile(int value = 0) : value(value)
+  {}
+
+  Fragile(const Fragile&) = default;
+
+  Fragile& operator=(const Fragile& other)
+  {
+    if (failing)
+        throw std::runtime_error("assignment failed");
+    value = other.value;
+    return *this;
+  }
+};
+
+bool Fragile::failing = false;
+
+}
+
+BOOST_AUTO_TEST_SUITE(ConcurrentHashMapTests)
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithDefaultConstructor_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.isEmpty());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithShardCount_ThenItIsRoundedToPowerOfTwo,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map(5);
+
+  BOOST_CHECK_EQUAL(map.getShardCount(), 8u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenInsertingItem_ThenItCanBeFound,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::string value;
+
+  BOOST_CHECK(map.insertOrAssign(42, "Alice"));
+
+  BOOST_REQUIRE(map.find(42, value));
+  BOOST_CHECK_EQUAL(value, "Alice");
+  BOOST_CHECK_EQUAL(map.getSize(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenAssigningExistingKey_ThenValueIsReplaced,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  map.insertOrAssign(42, "Alice");
+  std::string value;
+
+  BOOST_CHECK(!map.insertOrAssign(42, "Chuck"));
+
+  BOOST_REQUIRE(map.find(42, value));
+  BOOST_CHECK_EQUAL(value, "Chuck");
+  BOOST_CHECK_EQUAL(map.getSize(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenSearchingForMissingKey_ThenFalseIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  map.insertOrAssign(42, "Alice");
+  std::string value = "untouched";
+
+  BOOST_CHECK(!map.find(27, value));
+  BOOST_CHECK(!map.contains(27));
+  BOOST_CHECK_EQUAL(value, "untouched");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenRemovingKey_ThenItIsNoLongerInMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  map.insertOrAssign(42, "Alice");
+  map.insertOrAssign(27, "Bob");
+
+  BOOST_CHECK(map.remove(42));
+  BOOST_CHECK(!map.remove(42));
+
+  BOOST_CHECK(!map.contains(42));
+  BOOST_CHECK(map.contains(27));
+  BOOST_CHECK_EQUAL(map.getSize(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenComputingIfAbsent_ThenFactoryIsCalledOnlyForMissingKey,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  map.insertOrAssign(42, "Alice");
+  int calls = 0;
+  auto factory = [&calls](const K&) { calls++; return std::string("Bob"); };
+
+  BOOST_CHECK_EQUAL(map.computeIfAbsent(42, factory), "Alice");
+  BOOST_CHECK_EQUAL(map.computeIfAbsent(27, factory), "Bob");
+  BOOST_CHECK_EQUAL(map.computeIfAbsent(27, factory), "Bob");
+
+  BOOST_CHECK_EQUAL(calls, 1);
+  BOOST_CHECK_EQUAL(map.getSize(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(GivenThrowingValueOrFactory_WhenUpdating_ThenShardIsUnlocked)
+{
+  // one shard, so every key needs the lock the failed calls held
+  aisdi::ConcurrentHashMap<std::int32_t, Fragile> map(1);
+  map.insertOrAssign(1, Fragile(1));
+  Fragile found;
+
+  Fragile::failing = true;
+  BOOST_CHECK_THROW(map.insertOrAssign(1, Fragile(2)), std::runtime_error);
+  BOOST_CHECK_THROW(map.find(1, found), std::runtime_error);
+  Fragile::failing = false;
+  BOOST_CHECK_THROW(map.computeIfAbsent(2, [](std::int32_t) -> Fragile
+                                        { throw std::runtime_error("factory failed"); }),
+                    std::runtime_error);
+
+  map.insertOrAssign(3, Fragile(3));
+  BOOST_CHECK(map.find(1, found));
+  BOOST_CHECK_EQUAL(found.value, 1);
+  BOOST_CHECK(!map.contains(2));
+  BOOST_CHECK(map.remove(3));
+  BOOST_CHECK_EQUAL(map.getSize(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenManyThreadsInsertAndRemove_ThenAllSurvivingItemsAreFound,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  const int threadCount = 4;
+  const int perThread = 2000;
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < threadCount; t++)
+  {
+    threads.emplace_back([&map, t]()
+    {
+      for (int i = 0; i < perThread; i++)
+        map.insertOrAssign(t * perThread + i, std::to_string(i));
+      for (int i = 0; i < perThread; i += 2)
+        map.remove(t * perThread + i);
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  BOOST_CHECK_EQUAL(map.getSize(), static_cast<std::size_t>(threadCount * perThread / 2));
+  for (int key = 0; key < threadCount * perThread; key++)
+    BOOST_CHECK_EQUAL(map.contains(key), key % 2 == 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
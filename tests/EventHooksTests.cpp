@@ -0,0 +1,167 @@
+#include <EventHooks.h>
+#include <HashMap.h>
+#include <TreeMap.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using HookedMapTypes = boost::mpl::list<aisdi::TreeMap<std::int32_t, std::string>,
+                                        aisdi::HashMap<std::int32_t, std::string>>;
+
+namespace
+{
+
+// Collects the events of its lifetime; the hook is process-wide.
+struct RecordedEvents
+{
+  std::vector<aisdi::MapEvent> events;
+
+  explicit RecordedEvents(std::size_t minElements = 0)
+  {
+    aisdi::MapEvents::setHook([this](const aisdi::MapEvent& event)
+    {
+      events.push_back(event);
+    }, minElements);
+  }
+
+  ~RecordedEvents()
+  {
+    aisdi::MapEvents::removeHook();
+  }
+};
+
+template <typename Map>
+void fill(Map& map, std::int32_t count)
+{
+  for (std::int32_t key = 0; key < count; key++)
+    map[key] = "value";
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(EventHooksTests)
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenHook_WhenClearingMap_ThenOneEventWithItsSizeIsReported,
+                              Map,
+                              HookedMapTypes)
+{
+  Map map;
+  fill(map, 100);
+  RecordedEvents recorded;
+
+  map.clear();
+
+  BOOST_REQUIRE_EQUAL(recorded.events.size(), 1u);
+  BOOST_CHECK_EQUAL(recorded.events[0].kind, aisdi::MapEvent::Clear);
+  BOOST_CHECK_EQUAL(recorded.events[0].elements, 100u);
+  BOOST_CHECK(recorded.events[0].instance == &map);
+  BOOST_CHECK(recorded.events[0].duration.count() >= 0);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenHook_WhenCopyingAndDestroyingMap_ThenBothAreReported,
+                              Map,
+                              HookedMapTypes)
+{
+  Map map;
+  fill(map, 100);
+  RecordedEvents recorded;
+
+  {
+    const Map copy(map);
+  }
+
+  BOOST_REQUIRE_EQUAL(recorded.events.size(), 2u);
+  BOOST_CHECK_EQUAL(recorded.events[0].kind, aisdi::MapEvent::Copy);
+  BOOST_CHECK_EQUAL(recorded.events[0].elements, 100u);
+  BOOST_CHECK_EQUAL(recorded.events[1].kind, aisdi::MapEvent::Destroy);
+  BOOST_CHECK_EQUAL(recorded.events[1].elements, 100u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenThreshold_WhenClearingSmallerMap_ThenNothingIsReported,
+                              Map,
+                              HookedMapTypes)
+{
+  Map small;
+  Map large;
+  fill(small, 10);
+  fill(large, 1000);
+  RecordedEvents recorded(100);
+
+  small.clear();
+  large.clear();
+
+  BOOST_REQUIRE_EQUAL(recorded.events.size(), 1u);
+  BOOST_CHECK(recorded.events[0].instance == &large);
+}
+
+BOOST_AUTO_TEST_CASE(GivenHashMap_WhenAssigningCopy_ThenBucketsAreNotReportedSeparately)
+{
+  aisdi::HashMap<std::int32_t, std::string> map;
+  aisdi::HashMap<std::int32_t, std::string> other;
+  fill(map, 1000);
+  fill(other, 500);
+  RecordedEvents recorded;
+
+  map = other;
+
+  BOOST_REQUIRE_EQUAL(recorded.events.size(), 1u);
+  BOOST_CHECK_EQUAL(recorded.events[0].kind, aisdi::MapEvent::Copy);
+  BOOST_CHECK_EQUAL(recorded.events[0].map, std::string("HashMap"));
+  // the old entries freed and the new ones copied
+  BOOST_CHECK_EQUAL(recorded.events[0].elements, 1500u);
+}
+
+BOOST_AUTO_TEST_CASE(GivenChromeTraceWriter_WhenMapIsCleared_ThenCompleteEventIsWritten)
+{
+  std::ostringstream out;
+  {
+    aisdi::ChromeTraceWriter trace(out);
+    aisdi::MapEvents::setHook(std::ref(trace));
+    {
+      aisdi::TreeMap<std::int32_t, std::string> map;
+      fill(map, 3);
+      map.clear();
+    }
+    aisdi::MapEvents::removeHook();
+  }
+
+  const std::string json = out.str();
+  BOOST_CHECK_EQUAL(json.find("{\"traceEvents\": [\n"), 0u);
+  BOOST_CHECK(json.find("\"name\": \"TreeMap::clear\"") != std::string::npos);
+  BOOST_CHECK(json.find("\"ph\": \"X\"") != std::string::npos);
+  BOOST_CHECK(json.find("\"elements\": 3") != std::string::npos);
+  // the empty map's destructor reported no second event
+  BOOST_CHECK(json.find("},") == std::string::npos);
+  BOOST_CHECK_EQUAL(json.substr(json.size() - 4), "\n]}\n");
+}
+
+BOOST_AUTO_TEST_CASE(GivenChromeTraceWriter_WhenEventIsWritten_ThenStreamFormattingIsUnchanged)
+{
+  std::ostringstream out;
+  out.precision(2);
+  const std::ios_base::fmtflags flags = out.flags();
+  {
+    aisdi::ChromeTraceWriter trace(out);
+    aisdi::MapEvents::setHook(std::ref(trace));
+    {
+      aisdi::HashMap<std::int32_t, std::string> map;
+      fill(map, 3);
+      map.clear();
+    }
+    aisdi::MapEvents::removeHook();
+  }
+
+  BOOST_CHECK(out.flags() == flags);
+  BOOST_CHECK_EQUAL(out.precision(), 2);
+  out << 0.5;
+  BOOST_CHECK_EQUAL(out.str().substr(out.str().size() - 3), "0.5");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,112 @@
+#include <FrozenHashMap.h>
+#include <HashMap.h>
+#include <InstrumentedKey.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using K = std::int32_t;
+using Map = aisdi::FrozenHashMap<K, std::string>;
+
+BOOST_AUTO_TEST_SUITE(FrozenHashMapTests)
+
+BOOST_AUTO_TEST_CASE(GivenEmptyMap_WhenLookingUp_ThenNothingIsFound)
+{
+  const Map map;
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(map.begin() == map.end());
+  BOOST_CHECK(!map.contains(42));
+  BOOST_CHECK(map.tryGet(42) == nullptr);
+  BOOST_CHECK(map.find(42) == map.end());
+  BOOST_CHECK_THROW(map.valueOf(42), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(GivenInitializerList_WhenLookingUp_ThenValuesAreFound)
+{
+  const Map map = { { 753, "Rome" }, { 1410, "Grunwald" }, { 1683, "Vienna" } };
+
+  BOOST_CHECK_EQUAL(map.getSize(), 3u);
+  BOOST_CHECK_EQUAL(map.valueOf(1410), "Grunwald");
+  BOOST_CHECK_EQUAL(map.find(753)->second, "Rome");
+  BOOST_CHECK_EQUAL(*map.tryGet(1683), "Vienna");
+  BOOST_CHECK(!map.contains(1939));
+}
+
+BOOST_AUTO_TEST_CASE(GivenDuplicateKeys_WhenBuildingMap_ThenLaterValueWins)
+{
+  const Map map = { { 1, "first" }, { 2, "two" }, { 1, "second" } };
+
+  BOOST_CHECK_EQUAL(map.getSize(), 2u);
+  BOOST_CHECK_EQUAL(map.valueOf(1), "second");
+}
+
+BOOST_AUTO_TEST_CASE(GivenHashMap_WhenFreezingIt_ThenEveryKeyIsFoundAndNoOtherIs)
+{
+  aisdi::HashMap<K, std::string> source;
+  std::mt19937 random(2016);
+  std::vector<K> keys;
+  for (int i = 0; i < 20000; i++)
+  {
+    K key = static_cast<K>(random() % 1000000);
+    source[key] = std::to_string(key);
+    keys.push_back(key);
+  }
+
+  const Map map(source);
+
+  BOOST_CHECK_EQUAL(map.getSize(), source.getSize());
+  for (K key : keys)
+    BOOST_REQUIRE_EQUAL(map.valueOf(key), std::to_string(key));
+  for (K key = 1000000; key < 1010000; key++)
+    BOOST_REQUIRE(!map.contains(key));
+}
+
+BOOST_AUTO_TEST_CASE(GivenFrozenMap_WhenIterating_ThenEveryKeyAppearsOnce)
+{
+  std::vector<std::pair<K, std::string>> input;
+  for (K key = 0; key < 1000; key++)
+    input.emplace_back(key * 1000, "");
+  const Map map(input.begin(), input.end());
+
+  std::vector<K> iterated;
+  for (const auto& entry : map)
+    iterated.push_back(entry.first);
+  std::sort(iterated.begin(), iterated.end());
+
+  BOOST_REQUIRE_EQUAL(iterated.size(), 1000u);
+  for (K key = 0; key < 1000; key++)
+    BOOST_REQUIRE_EQUAL(iterated[key], key * 1000);
+}
+
+BOOST_AUTO_TEST_CASE(GivenLargeKeySet_WhenFreezing_ThenIndexTakesFewBitsPerKey)
+{
+  std::vector<std::pair<K, char>> input;
+  for (K key = 0; key < 100000; key++)
+    input.emplace_back(key, 'x');
+  const aisdi::FrozenHashMap<K, char> map(input.begin(), input.end());
+
+  BOOST_CHECK_LE(map.indexBytes() * 8.0 / map.getSize(), 4.5);
+}
+
+BOOST_AUTO_TEST_CASE(GivenFrozenMap_WhenLookingUp_ThenKeyIsHashedAndComparedOnce)
+{
+  using Key = aisdi::InstrumentedKey<K>;
+  const aisdi::FrozenHashMap<Key, std::string> map = { { 1, "one" }, { 2, "two" }, { 3, "three" } };
+
+  const aisdi::KeyCounters before = aisdi::keyCounters();
+  BOOST_CHECK(map.contains(2));
+  BOOST_CHECK(!map.contains(4));
+  const aisdi::KeyCounters counted = aisdi::keyCounters() - before;
+
+  BOOST_CHECK_EQUAL(counted.hashes, 2u);
+  BOOST_CHECK_EQUAL(counted.comparisons, 2u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
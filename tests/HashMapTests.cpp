@@ -2,7 +2,9 @@
 
 #include <cstdint>
 #include <string>
+#include <iterator>
 #include <map>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -470,6 +472,82 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenChangingValueOfAKey_ThenValue
   thenMapContainsItems(map, { { 42, "Chuck" }, { 27, "Bob" } });
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenTryingToGetAnyKey_ThenNullIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.tryGet(1) == nullptr);
+  BOOST_CHECK(!map.contains(1));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenTryingToGetMissingKey_ThenNullIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  BOOST_CHECK(map.tryGet(1) == nullptr);
+  BOOST_CHECK(!map.contains(1));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenTryingToGetAKey_ThenValueCanBeChanged,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  std::string* value = map.tryGet(42);
+  BOOST_REQUIRE(value != nullptr);
+  *value = "Chuck";
+
+  BOOST_CHECK(map.contains(42));
+  thenMapContainsItems(map, { { 42, "Chuck" }, { 27, "Bob" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenFindingManyKeys_ThenValuesAreReturnedInOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::vector<K> keys;
+  for (K key = 0; key < 100; key++)
+  {
+    if (key % 3 == 0)
+      map[key] = std::to_string(key);
+    keys.push_back(key);
+  }
+  std::vector<const std::string*> values;
+
+  map.findMany(keys.begin(), keys.end(), std::back_inserter(values));
+
+  BOOST_REQUIRE_EQUAL(values.size(), keys.size());
+  for (std::size_t i = 0; i < keys.size(); i++)
+  {
+    if (keys[i] % 3 == 0)
+    {
+      BOOST_REQUIRE(values[i] != nullptr);
+      BOOST_CHECK_EQUAL(*values[i], std::to_string(keys[i]));
+    }
+    else
+      BOOST_CHECK(values[i] == nullptr);
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenCheckingManyKeys_ThenPresenceIsReported,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+  const std::vector<K> keys = { 27, 1, 42, 92 };
+  std::vector<bool> present;
+
+  map.containsMany(keys.begin(), keys.end(), std::back_inserter(present));
+
+  BOOST_CHECK(present == std::vector<bool>({ true, false, true, false }));
+}
+
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenRemovingValueByKey_ThenExceptionIsThrown,
                               K,
                               TestedKeyTypes)
@@ -591,6 +669,144 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMapsWithDifferentKeys_WhenComparingThem_Th
   BOOST_CHECK(map != other);
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenInsertingOrGettingKey_ThenItemIsInserted,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  auto result = map.insertOrGet(42);
+  result.first->second = "Alice";
+
+  BOOST_CHECK(result.second);
+  BOOST_CHECK_EQUAL(result.first->first, 42);
+  thenMapContainsItems(map, { { 42, "Alice" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenInsertingOrGettingExistingKey_ThenItemIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  auto result = map.insertOrGet(42);
+
+  BOOST_CHECK(!result.second);
+  BOOST_CHECK_EQUAL(result.first->second, "Alice");
+  BOOST_CHECK_EQUAL(map.getSize(), 2);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenKeysSharingBucketIndex_WhenAddingThem_ThenEachIsCounted,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  map[1000] = "Alice";
+  map[0] = "Bob";
+  map[50] = "Chuck";
+  map[0] = "Dave";
+
+  BOOST_CHECK_EQUAL(map.getSize(), 3);
+  thenMapContainsItems(map, { { 1000, "Alice" }, { 0, "Dave" }, { 50, "Chuck" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenClearing_ThenMapBecomesEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 753, "Rome" }, { 1410, "Grunwald" }, { 1789, "Paris" } };
+
+  map.clear();
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK_EQUAL(map.getSize(), 0);
+  BOOST_CHECK(map.find(753) == map.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenClearedMap_WhenAddingItem_ThenItemIsInMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+  map.clear();
+
+  map[13] = "Chuck";
+
+  thenMapContainsItems(map, { { 13, "Chuck" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenItemsInManyBuckets_WhenIterating_ThenEachItemIsVisitedOnce,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  for (K key = 0; key < 300; key += 7)
+  {
+    map[key] = std::to_string(key);
+    expected[key] = std::to_string(key);
+  }
+
+  std::map<K, std::string> forward;
+  for (auto it = map.begin(); it != map.end(); ++it)
+    BOOST_CHECK(forward.insert(*it).second);
+  std::map<K, std::string> backward;
+  for (auto it = map.end(); it != map.begin();)
+  {
+    --it;
+    BOOST_CHECK(backward.insert(*it).second);
+  }
+
+  BOOST_CHECK(forward == expected);
+  BOOST_CHECK(backward == expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoKeysPerBucket_WhenReadingBucketStats_ThenSpreadIsEven,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  const K buckets = map.bucketCount();
+  for (K key = 0; key < 2 * buckets; key++)
+    map[key] = "x";
+
+  const aisdi::BucketStats stats = map.bucketStats();
+
+  BOOST_CHECK_EQUAL(stats.size, 2 * buckets);
+  BOOST_CHECK_CLOSE(stats.loadFactor, 2.0, 1e-9);
+  BOOST_CHECK_EQUAL(stats.occupiedBuckets, buckets);
+  BOOST_CHECK_CLOSE(stats.occupiedRatio, 1.0, 1e-9);
+  BOOST_CHECK_EQUAL(stats.longestBucket, 2);
+  const std::vector<std::size_t> sizes = { 0, 0, static_cast<std::size_t>(buckets) };
+  BOOST_CHECK(stats.sizeHistogram == sizes);
+  BOOST_CHECK_CLOSE(stats.expectedProbeLength, 1.5, 1e-9);
+  BOOST_CHECK_CLOSE(stats.observedProbeLength, 1.5, 1e-9);
+  BOOST_CHECK_SMALL(stats.chiSquared(), 1e-9);
+  BOOST_CHECK(stats.uniformityZ() < -3.0);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenKeysStridedByBucketCount_WhenReadingBucketStats_ThenHashIsReportedNonUniform,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  const K buckets = map.bucketCount();
+  for (K i = 0; i < 100; i++)
+  {
+    map[i * buckets] = "x";
+    BOOST_CHECK_EQUAL(map.bucketOf(i * buckets), 0u);
+  }
+
+  const aisdi::BucketStats stats = map.bucketStats();
+
+  BOOST_CHECK_EQUAL(stats.occupiedBuckets, 1);
+  BOOST_CHECK_EQUAL(stats.longestBucket, 100);
+  BOOST_CHECK_EQUAL(stats.sizeHistogram[0], buckets - 1);
+  BOOST_CHECK(stats.observedProbeLength > stats.expectedProbeLength);
+  BOOST_CHECK(stats.uniformityZ() > 3.0);
+}
+
 // ConstIterator is tested via Iterator methods.
 // If Iterator methods are to be changed, then new ConstIterator tests are required.
 
@@ -0,0 +1,95 @@
+#include <InstrumentedKey.h>
+#include <HashMap.h>
+#include <TreeMap.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using Key = aisdi::InstrumentedKey<std::int32_t>;
+
+using InstrumentedMapTypes = boost::mpl::list<aisdi::TreeMap<Key, std::string>,
+                                              aisdi::HashMap<Key, std::string>>;
+
+BOOST_AUTO_TEST_SUITE(InstrumentedKeyTests)
+
+BOOST_AUTO_TEST_CASE(GivenThreeNodeTree_WhenLookingUpLeaf_ThenTwoNodesAreVisited)
+{
+  aisdi::TreeMap<Key, std::string> map;
+  map[2] = "root";
+  map[1] = "left";
+  map[3] = "right";
+
+  const aisdi::KeyCounters before = aisdi::keyCounters();
+  BOOST_CHECK(map.contains(3));
+  const aisdi::KeyCounters counted = aisdi::keyCounters() - before;
+
+  BOOST_CHECK_EQUAL(counted.visits, 2u);
+  // != and > at the root, != at the leaf
+  BOOST_CHECK_EQUAL(counted.comparisons, 3u);
+  BOOST_CHECK_EQUAL(counted.hashes, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(GivenHashMap_WhenLookingUp_ThenKeyIsHashedOnce)
+{
+  aisdi::HashMap<Key, std::string> map;
+  map[42] = "Alice";
+
+  const aisdi::KeyCounters before = aisdi::keyCounters();
+  BOOST_CHECK(map.tryGet(42) != nullptr);
+  const aisdi::KeyCounters counted = aisdi::keyCounters() - before;
+
+  BOOST_CHECK_EQUAL(counted.hashes, 1u);
+  BOOST_CHECK_EQUAL(counted.visits, 1u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenIterating_ThenNoKeyIsComparedOrHashed,
+                              Map,
+                              InstrumentedMapTypes)
+{
+  Map map;
+  for (std::int32_t key = 0; key < 100; key += 7)
+    map[key] = "value";
+
+  const aisdi::KeyCounters before = aisdi::keyCounters();
+  std::size_t visited = 0;
+  for (auto it = map.begin(); it != map.end(); ++it)
+    visited++;
+  const aisdi::KeyCounters counted = aisdi::keyCounters() - before;
+
+  BOOST_CHECK_EQUAL(visited, map.getSize());
+  BOOST_CHECK_EQUAL(counted.comparisons, 0u);
+  BOOST_CHECK_EQUAL(counted.hashes, 0u);
+  BOOST_CHECK_EQUAL(counted.visits, 0u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenKeys_WhenLookingThemUpInBatch_ThenSameNodesAreVisited,
+                              Map,
+                              InstrumentedMapTypes)
+{
+  Map map;
+  std::vector<Key> keys;
+  for (std::int32_t key = 0; key < 200; key++)
+  {
+    map[(key * 37) % 211] = "value";
+    keys.push_back(key);
+  }
+
+  aisdi::KeyCounters before = aisdi::keyCounters();
+  for (const Key& key : keys)
+    map.contains(key);
+  const std::uint64_t oneByOne = (aisdi::keyCounters() - before).visits;
+
+  std::vector<const std::string*> found(keys.size());
+  before = aisdi::keyCounters();
+  map.findMany(keys.begin(), keys.end(), found.begin());
+  const std::uint64_t batched = (aisdi::keyCounters() - before).visits;
+
+  BOOST_CHECK_EQUAL(batched, oneByOne);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
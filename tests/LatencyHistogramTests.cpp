@@ -0,0 +1,102 @@
+#include <LatencyHistogram.h>
+#include <LatencyTracked.h>
+#include <HashMap.h>
+#include <TreeMap.h>
+
+#include <cstdint>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using TrackedMapTypes = boost::mpl::list<aisdi::TreeMap<std::int32_t, std::string>,
+                                         aisdi::HashMap<std::int32_t, std::string>>;
+
+BOOST_AUTO_TEST_SUITE(LatencyHistogramTests)
+
+BOOST_AUTO_TEST_CASE(GivenEmptyHistogram_WhenReadingPercentiles_ThenZeroIsReturned)
+{
+  const aisdi::LatencyHistogram histogram;
+
+  BOOST_CHECK_EQUAL(histogram.getCount(), 0u);
+  BOOST_CHECK_EQUAL(histogram.percentile(0.5), 0u);
+  BOOST_CHECK_EQUAL(histogram.getMax(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSmallValues_WhenReadingPercentiles_ThenTheyAreExact)
+{
+  aisdi::LatencyHistogram histogram;
+
+  for (std::uint64_t value = 1; value <= 10; value++)
+    histogram.record(value);
+
+  BOOST_CHECK_EQUAL(histogram.getCount(), 10u);
+  BOOST_CHECK_EQUAL(histogram.getMin(), 1u);
+  BOOST_CHECK_EQUAL(histogram.percentile(0.5), 5u);
+  BOOST_CHECK_EQUAL(histogram.percentile(0.9), 9u);
+  BOOST_CHECK_EQUAL(histogram.percentile(1.0), 10u);
+}
+
+BOOST_AUTO_TEST_CASE(GivenLargeValues_WhenReadingPercentiles_ThenRelativeErrorIsSmall)
+{
+  aisdi::LatencyHistogram histogram;
+
+  for (std::uint64_t value = 1000; value <= 1000000; value += 1000)
+    histogram.record(value);
+
+  const std::uint64_t p99 = histogram.percentile(0.99);
+  BOOST_CHECK(p99 >= 990000);
+  BOOST_CHECK(p99 <= 990000 + 990000 / 32);
+  BOOST_CHECK_EQUAL(histogram.getMax(), 1000000u);
+  BOOST_CHECK_EQUAL(histogram.percentile(0.999999), 1000000u);
+}
+
+BOOST_AUTO_TEST_CASE(GivenOutlier_WhenReadingTail_ThenOnlyHighestPercentilesSeeIt)
+{
+  aisdi::LatencyHistogram histogram;
+  histogram.record(20, 999);
+
+  histogram.record(UINT64_MAX);
+
+  BOOST_CHECK_EQUAL(histogram.percentile(0.99), 20u);
+  BOOST_CHECK_EQUAL(histogram.percentile(0.9991), UINT64_MAX);
+  BOOST_CHECK_EQUAL(histogram.getMax(), UINT64_MAX);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTwoHistograms_WhenMerging_ThenCountsAndExtremesAreCombined)
+{
+  aisdi::LatencyHistogram histogram;
+  aisdi::LatencyHistogram other;
+  histogram.record(5);
+  other.record(3);
+  other.record(700);
+
+  histogram.merge(other);
+
+  BOOST_CHECK_EQUAL(histogram.getCount(), 3u);
+  BOOST_CHECK_EQUAL(histogram.getMin(), 3u);
+  BOOST_CHECK_EQUAL(histogram.getMax(), 700u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTrackedMap_WhenUsingIt_ThenEveryOperationIsRecorded,
+                              Map,
+                              TrackedMapTypes)
+{
+  aisdi::LatencyTracked<Map> map;
+
+  map[42] = "Alice";
+  map[27] = "Bob";
+  BOOST_CHECK(map.contains(42));
+  BOOST_CHECK(map.tryGet(13) == nullptr);
+  map.remove(27);
+
+  using Tracked = aisdi::LatencyTracked<Map>;
+  BOOST_CHECK_EQUAL(map.latency(Tracked::Index).getCount(), 2u);
+  BOOST_CHECK_EQUAL(map.latency(Tracked::Find).getCount(), 2u);
+  BOOST_CHECK_EQUAL(map.latency(Tracked::Remove).getCount(), 1u);
+  BOOST_CHECK_EQUAL(map.getSize(), 1u);
+  BOOST_CHECK_EQUAL(map.underlying().valueOf(42), "Alice");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,125 @@
+#include <ReadMostlyHashMap.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+
+template <typename K>
+using Map = aisdi::ReadMostlyHashMap<K, std::string>;
+
+BOOST_AUTO_TEST_SUITE(ReadMostlyHashMapTests)
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithDefaultConstructor_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.isEmpty());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenHashMap_WhenCreatingFromIt_ThenAllItemsAreVisible,
+                              K,
+                              TestedKeyTypes)
+{
+  const aisdi::HashMap<K, std::string> initial = { { 753, "Rome" }, { 1789, "Paris" } };
+  const Map<K> map(initial);
+  std::string value;
+
+  BOOST_REQUIRE(map.find(753, value));
+  BOOST_CHECK_EQUAL(value, "Rome");
+  BOOST_CHECK(map.contains(1789));
+  BOOST_CHECK(!map.contains(1410));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenInsertingItem_ThenItCanBeFound,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::string value;
+
+  map.insertOrAssign(42, "Alice");
+  map.insertOrAssign(42, "Chuck");
+
+  BOOST_REQUIRE(map.find(42, value));
+  BOOST_CHECK_EQUAL(value, "Chuck");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenRemovingKey_ThenItIsNoLongerInMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  map.insertOrAssign(42, "Alice");
+  map.insertOrAssign(27, "Bob");
+
+  BOOST_CHECK(map.remove(42));
+  BOOST_CHECK(!map.remove(42));
+
+  BOOST_CHECK(!map.contains(42));
+  BOOST_CHECK(map.contains(27));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenClearing_ThenMapBecomesEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  map.insertOrAssign(42, "Alice");
+
+  map.clear();
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(!map.contains(42));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenReaders_WhenWriterUpdatesInBatches_ThenEachReadSeesWholeBatch,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  map.update([](aisdi::HashMap<K, std::string>& table) { table[1] = "0"; table[2] = "0"; });
+  std::atomic<bool> done(false);
+  std::atomic<int> tornReads(0);
+  std::vector<std::thread> readers;
+
+  for (int t = 0; t < 3; t++)
+  {
+    readers.emplace_back([&map, &done, &tornReads]()
+    {
+      while (!done.load())
+      {
+        bool consistent = map.read([](const aisdi::HashMap<K, std::string>& table)
+        {
+          return table.valueOf(1) == table.valueOf(2);
+        });
+        if (!consistent)
+          tornReads++;
+      }
+    });
+  }
+  for (int i = 1; i <= 200; i++)
+  {
+    const std::string value = std::to_string(i);
+    map.update([&value](aisdi::HashMap<K, std::string>& table) { table[1] = value; table[2] = value; });
+  }
+  done = true;
+  for (auto& reader : readers)
+    reader.join();
+
+  std::string value;
+  BOOST_CHECK_EQUAL(tornReads.load(), 0);
+  BOOST_REQUIRE(map.find(2, value));
+  BOOST_CHECK_EQUAL(value, "200");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
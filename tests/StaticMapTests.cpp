@@ -0,0 +1,118 @@
+#include <StaticMap.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+namespace
+{
+
+using Entry = aisdi::StaticEntry<std::int32_t, const char*>;
+
+constexpr Entry battles[] = {
+  { 1683, "Vienna" }, { 753, "Rome" }, { 1410, "Grunwald" }, { -490, "Marathon" }, { 1939, "Westerplatte" }
+};
+
+constexpr auto flatBattles = aisdi::makeStaticFlatMap(battles);
+constexpr auto hashedBattles = aisdi::makeStaticHashMap(battles);
+
+// built and looked up by the compiler
+static_assert(flatBattles.contains(1410) && !flatBattles.contains(1410 + 1), "flat lookup");
+static_assert(flatBattles.valueOf(-490)[0] == 'M', "flat value");
+static_assert(flatBattles.begin()->first == -490, "flat entries are sorted");
+static_assert(hashedBattles.contains(1683) && !hashedBattles.contains(0), "hashed lookup");
+static_assert(hashedBattles.valueOf(753)[0] == 'R', "hashed value");
+static_assert(aisdi::makeStaticFlatMap<int, int>({ { 2, 4 }, { 1, 1 }, { 3, 9 } }).valueOf(3) == 9,
+              "braced list");
+
+template <std::size_t N>
+struct SquaresTable
+{
+  aisdi::StaticEntry<std::int32_t, std::int32_t> entries[N];
+
+  constexpr SquaresTable() : entries()
+  {
+    for (std::size_t i = 0; i < N; i++)
+    {
+      entries[i].first = static_cast<std::int32_t>(i * 7919 % 100003);
+      entries[i].second = static_cast<std::int32_t>(i * i);
+    }
+  }
+};
+
+constexpr SquaresTable<500> squares;
+constexpr auto hashedSquares = aisdi::makeStaticHashMap(squares.entries);
+constexpr auto flatSquares = aisdi::makeStaticFlatMap(squares.entries);
+
+}
+
+using StaticMapTypes = boost::mpl::list<decltype(flatBattles), decltype(hashedBattles)>;
+
+BOOST_AUTO_TEST_SUITE(StaticMapTests)
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenStaticMap_WhenLookingUpKeys_ThenTheirValuesAreFound,
+                              Map,
+                              StaticMapTypes)
+{
+  const Map map(battles);
+
+  BOOST_CHECK_EQUAL(map.getSize(), 5u);
+  for (const Entry& battle : battles)
+  {
+    BOOST_CHECK_EQUAL(std::string(map.valueOf(battle.first)), battle.second);
+    BOOST_CHECK_EQUAL(map.find(battle.first)->second, battle.second);
+    BOOST_CHECK_EQUAL(*map.tryGet(battle.first), battle.second);
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenStaticMap_WhenLookingUpMissingKey_ThenNothingIsFound,
+                              Map,
+                              StaticMapTypes)
+{
+  const Map map(battles);
+
+  for (std::int32_t key : { -1000, -491, 0, 1000, 1940, 5000 })
+  {
+    BOOST_CHECK(!map.contains(key));
+    BOOST_CHECK(map.find(key) == map.end());
+    BOOST_CHECK(map.tryGet(key) == nullptr);
+  }
+  BOOST_CHECK_THROW(map.valueOf(42), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenDuplicateKey_WhenBuildingAtRunTime_ThenExceptionIsThrown,
+                              Map,
+                              StaticMapTypes)
+{
+  const Entry duplicated[] = { { 1, "a" }, { 2, "b" }, { 3, "c" }, { 4, "d" }, { 2, "e" } };
+
+  BOOST_CHECK_THROW(Map map(duplicated), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(GivenFlatMap_WhenIterating_ThenKeysAreInOrder)
+{
+  std::int32_t previous = flatSquares.begin()->first;
+  std::size_t count = 1;
+  for (auto it = flatSquares.begin() + 1; it != flatSquares.end(); ++it, ++count)
+  {
+    BOOST_REQUIRE_LT(previous, it->first);
+    previous = it->first;
+  }
+  BOOST_CHECK_EQUAL(count, 500u);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCompileTimeHashMap_WhenLookingUpEveryKey_ThenEachIsFound)
+{
+  for (const auto& square : squares.entries)
+  {
+    BOOST_REQUIRE_EQUAL(hashedSquares.valueOf(square.first), square.second);
+    BOOST_REQUIRE_EQUAL(flatSquares.valueOf(square.first), square.second);
+  }
+  BOOST_CHECK(!hashedSquares.contains(1));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
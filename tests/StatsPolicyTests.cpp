@@ -0,0 +1,134 @@
+#include <StatsPolicy.h>
+#include <HashMap.h>
+#include <TreeMap.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using CountedMapTypes = boost::mpl::list<aisdi::TreeMap<std::int32_t, std::string, aisdi::CountingStats>,
+                                         aisdi::HashMap<std::int32_t, std::string, aisdi::CountingStats>>;
+
+BOOST_AUTO_TEST_SUITE(StatsPolicyTests)
+
+BOOST_AUTO_TEST_CASE(GivenDefaultPolicy_WhenUsingTreeMap_ThenNothingIsCountedOrStored)
+{
+  aisdi::TreeMap<std::int32_t, std::string> map;
+  map[42] = "Alice";
+  BOOST_CHECK(map.contains(42));
+
+  const aisdi::MapCounters counters = map.counters();
+
+  BOOST_CHECK_EQUAL(counters.hits + counters.misses + counters.inserts + counters.probes, 0u);
+  // root and size only: the empty policy takes no space
+  BOOST_CHECK_EQUAL(sizeof(map), sizeof(void*) + sizeof(std::size_t));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenCountingPolicy_WhenUsingMap_ThenEveryOperationIsCounted,
+                              Map,
+                              CountedMapTypes)
+{
+  Map map;
+
+  map[42] = "Alice";
+  map[27] = "Bob";
+  map[42] = "Carol";
+  BOOST_CHECK(map.contains(27));
+  BOOST_CHECK(map.tryGet(13) == nullptr);
+  BOOST_CHECK(map.find(7) == map.end());
+  map.remove(27);
+
+  const aisdi::MapCounters counters = map.counters();
+  BOOST_CHECK_EQUAL(counters.inserts, 2u);
+  // the second map[42] finds its key
+  BOOST_CHECK_EQUAL(counters.hits, 2u);
+  BOOST_CHECK_EQUAL(counters.misses, 2u);
+  BOOST_CHECK_EQUAL(counters.erases, 1u);
+  BOOST_CHECK(counters.averageProbeLength() > 0.0);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyCountedMap_WhenLookingUp_ThenEveryMissIsCounted,
+                              Map,
+                              CountedMapTypes)
+{
+  Map map;
+  const Map& constMap = map;
+
+  BOOST_CHECK(map.find(42) == map.end());
+  BOOST_CHECK(constMap.find(42) == constMap.end());
+  BOOST_CHECK_THROW(map.valueOf(42), std::out_of_range);
+  BOOST_CHECK_THROW(constMap.valueOf(42), std::out_of_range);
+  BOOST_CHECK(!map.contains(42));
+
+  BOOST_CHECK_EQUAL(map.counters().misses, 5u);
+  BOOST_CHECK_EQUAL(map.counters().hits, 0u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenCountingPolicy_WhenLookingUpInBatch_ThenEveryKeyIsCounted,
+                              Map,
+                              CountedMapTypes)
+{
+  Map map;
+  for (std::int32_t key = 0; key < 100; key += 2)
+    map[key] = "x";
+  map.resetCounters();
+
+  std::vector<std::int32_t> keys;
+  for (std::int32_t key = 0; key < 100; key++)
+    keys.push_back(key);
+  std::vector<const std::string*> found(keys.size());
+  map.findMany(keys.begin(), keys.end(), found.begin());
+
+  const aisdi::MapCounters counters = map.counters();
+  BOOST_CHECK_EQUAL(counters.hits, 50u);
+  BOOST_CHECK_EQUAL(counters.misses, 50u);
+  BOOST_CHECK_EQUAL(counters.inserts, 0u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenCountedMap_WhenCopyingIt_ThenCopyStartsFromZero,
+                              Map,
+                              CountedMapTypes)
+{
+  Map map;
+  map[42] = "Alice";
+  BOOST_CHECK(map.contains(42));
+
+  const Map copy(map);
+
+  BOOST_CHECK_EQUAL(copy.counters().hits, 0u);
+  BOOST_CHECK_EQUAL(copy.counters().inserts, 0u);
+  BOOST_CHECK_EQUAL(map.counters().hits, 1u);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenConcurrentReaders_WhenLookingUp_ThenNoCountIsLost,
+                              Map,
+                              CountedMapTypes)
+{
+  Map map;
+  for (std::int32_t key = 0; key < 64; key++)
+    map[key] = "x";
+  map.resetCounters();
+
+  std::vector<std::thread> readers;
+  for (int reader = 0; reader < 4; reader++)
+    readers.emplace_back([&map]()
+    {
+      const Map& constMap = map;
+      for (int round = 0; round < 1000; round++)
+        for (std::int32_t key = 0; key < 64; key++)
+          constMap.contains(key);
+    });
+  for (std::thread& reader : readers)
+    reader.join();
+
+  BOOST_CHECK_EQUAL(map.counters().hits, 4u * 1000 * 64);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
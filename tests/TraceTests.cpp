@@ -0,0 +1,114 @@
+#include <Trace.h>
+#include <HashMap.h>
+#include <TreeMap.h>
+
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+using RecordedMapTypes = boost::mpl::list<aisdi::TreeMap<std::int32_t, std::string>,
+                                          aisdi::HashMap<std::uint64_t, std::string>>;
+
+using aisdi::TraceEntry;
+
+BOOST_AUTO_TEST_SUITE(TraceTests)
+
+BOOST_AUTO_TEST_CASE(GivenWrittenOperations_WhenReadingTrace_ThenTheyAreReturnedInOrder)
+{
+  std::stringstream stream;
+  {
+    aisdi::TraceWriter writer(stream);
+    writer.write(TraceEntry::Insert, 42);
+    writer.write(TraceEntry::Lookup, 7);
+    writer.write(TraceEntry::Range, UINT64_MAX, 300);
+    writer.write(TraceEntry::Iterate);
+    writer.write(TraceEntry::Remove, 0);
+    writer.write(TraceEntry::Clear);
+  }
+
+  const std::vector<TraceEntry> entries = aisdi::readTrace(stream);
+
+  BOOST_REQUIRE_EQUAL(entries.size(), 6u);
+  BOOST_CHECK(entries[0].operation == TraceEntry::Insert);
+  BOOST_CHECK_EQUAL(entries[0].key, 42u);
+  BOOST_CHECK(entries[1].operation == TraceEntry::Lookup);
+  BOOST_CHECK_EQUAL(entries[1].key, 7u);
+  BOOST_CHECK(entries[2].operation == TraceEntry::Range);
+  BOOST_CHECK_EQUAL(entries[2].key, UINT64_MAX);
+  BOOST_CHECK_EQUAL(entries[2].count, 300u);
+  BOOST_CHECK(entries[3].operation == TraceEntry::Iterate);
+  BOOST_CHECK(entries[4].operation == TraceEntry::Remove);
+  BOOST_CHECK_EQUAL(entries[4].key, 0u);
+  BOOST_CHECK(entries[5].operation == TraceEntry::Clear);
+}
+
+BOOST_AUTO_TEST_CASE(GivenConsecutiveKeys_WhenWritingTrace_ThenEachTakesTwoBytes)
+{
+  std::stringstream stream;
+  {
+    aisdi::TraceWriter writer(stream);
+    for (std::uint64_t key = 1000000; key < 1000100; key++)
+      writer.write(TraceEntry::Insert, key);
+  }
+
+  BOOST_CHECK(stream.str().size() <= 8 + 4 + 100 * 2);
+  BOOST_CHECK_EQUAL(aisdi::readTrace(stream).back().key, 1000099u);
+}
+
+BOOST_AUTO_TEST_CASE(GivenOtherData_WhenReadingTrace_ThenExceptionIsThrown)
+{
+  std::stringstream stream("operation,map\n");
+
+  BOOST_CHECK_THROW(aisdi::readTrace(stream), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTruncatedTrace_WhenReadingIt_ThenExceptionIsThrown)
+{
+  std::stringstream stream;
+  {
+    aisdi::TraceWriter writer(stream);
+    writer.write(TraceEntry::Lookup, UINT64_MAX / 3);
+  }
+  std::string bytes = stream.str();
+  std::stringstream truncated(bytes.substr(0, bytes.size() - 1));
+
+  BOOST_CHECK_THROW(aisdi::readTrace(truncated), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenRecorder_WhenUsingMap_ThenOperationsAreTraced,
+                              Map,
+                              RecordedMapTypes)
+{
+  std::stringstream stream;
+  {
+    aisdi::TraceRecorder<Map> map(stream);
+    map[42] = "Alice";
+    map[27] = "Bob";
+    BOOST_CHECK(map.contains(27));
+    std::string visited;
+    map.forRange(42, 1, [&](const typename Map::value_type& item) { visited += item.second; });
+    BOOST_CHECK_EQUAL(visited, "Alice");
+    map.remove(42);
+    BOOST_CHECK_EQUAL(map.getRecorded(), 5u);
+    BOOST_CHECK_EQUAL(map.underlying().getSize(), 1u);
+  }
+
+  const std::vector<TraceEntry> entries = aisdi::readTrace(stream);
+
+  BOOST_REQUIRE_EQUAL(entries.size(), 5u);
+  BOOST_CHECK(entries[1].operation == TraceEntry::Insert);
+  BOOST_CHECK_EQUAL(entries[1].key, 27u);
+  BOOST_CHECK(entries[2].operation == TraceEntry::Lookup);
+  BOOST_CHECK(entries[3].operation == TraceEntry::Range);
+  BOOST_CHECK_EQUAL(entries[3].count, 1u);
+  BOOST_CHECK(entries[4].operation == TraceEntry::Remove);
+  BOOST_CHECK_EQUAL(entries[4].key, 42u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -2,7 +2,10 @@
 
 #include <cstdint>
 #include <string>
+#include <iterator>
 #include <map>
+#include <memory>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -337,6 +340,26 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenCreatingCopy_ThenAllItemsAreC
   thenMapContainsItems(other, { { 753, "Rome" }, { 1789, "Paris" } });
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenBranchingTree_WhenCreatingCopy_ThenItemsAreCopiedInOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 50, "e" }, { 20, "b" }, { 80, "h" }, { 10, "a" }, { 30, "c" },
+                 { 40, "d" }, { 70, "g" }, { 60, "f" }, { 90, "i" } };
+  Map<K> other;
+  other[5] = "x";
+
+  other = map;
+  map.remove(50);
+
+  std::string values;
+  for (const auto& item : other)
+    values += item.second;
+  BOOST_CHECK_EQUAL(values, "abcdefghi");
+  BOOST_CHECK_EQUAL(other.getSize(), 9);
+  BOOST_CHECK_EQUAL(other.valueOf(50), "e");
+}
+
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenMovingToOther_ThenBothMapsAreEmpty,
                               K,
                               TestedKeyTypes)
@@ -470,6 +493,82 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenChangingValueOfAKey_ThenValue
   thenMapContainsItems(map, { { 42, "Chuck" }, { 27, "Bob" } });
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenTryingToGetAnyKey_ThenNullIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.tryGet(1) == nullptr);
+  BOOST_CHECK(!map.contains(1));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenTryingToGetMissingKey_ThenNullIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  BOOST_CHECK(map.tryGet(1) == nullptr);
+  BOOST_CHECK(!map.contains(1));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenTryingToGetAKey_ThenValueCanBeChanged,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  std::string* value = map.tryGet(42);
+  BOOST_REQUIRE(value != nullptr);
+  *value = "Chuck";
+
+  BOOST_CHECK(map.contains(42));
+  thenMapContainsItems(map, { { 42, "Chuck" }, { 27, "Bob" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenFindingManyKeys_ThenValuesAreReturnedInOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::vector<K> keys;
+  for (K key = 0; key < 200; key++)
+  {
+    if (key % 3 == 0)
+      map[(key * 37) % 200] = std::to_string((key * 37) % 200);
+    keys.push_back(key);
+  }
+  std::vector<const std::string*> values;
+
+  map.findMany(keys.begin(), keys.end(), std::back_inserter(values));
+
+  BOOST_REQUIRE_EQUAL(values.size(), keys.size());
+  for (std::size_t i = 0; i < keys.size(); i++)
+  {
+    if (map.contains(keys[i]))
+    {
+      BOOST_REQUIRE(values[i] != nullptr);
+      BOOST_CHECK_EQUAL(*values[i], std::to_string(keys[i]));
+    }
+    else
+      BOOST_CHECK(values[i] == nullptr);
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenFindingManyKeys_ThenAllAreMissing,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+  const std::vector<K> keys = { 1, 2, 3 };
+  std::vector<const std::string*> values;
+
+  map.findMany(keys.begin(), keys.end(), std::back_inserter(values));
+
+  BOOST_CHECK(values == std::vector<const std::string*>(3, nullptr));
+}
+
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenRemovingValueByKey_ThenExceptionIsThrown,
                               K,
                               TestedKeyTypes)
@@ -499,6 +598,23 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenRemovingValueByKey_ThenItemIs
   thenMapContainsItems(map, { { 42, "Alice" } });
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenItemWithTwoChildren_WhenRemovingIt_ThenItsValueIsDestroyed,
+                              K,
+                              TestedKeyTypes)
+{
+  aisdi::TreeMap<K, std::shared_ptr<int>> map;
+  const auto value = std::make_shared<int>(42);
+  map[50] = value;
+  map[20] = std::make_shared<int>(20);
+  map[80] = std::make_shared<int>(80);
+
+  map.remove(50);
+
+  BOOST_CHECK_EQUAL(value.use_count(), 1);
+  BOOST_CHECK_EQUAL(map.getSize(), 2);
+  BOOST_CHECK_EQUAL(*map.valueOf(80), 80);
+}
+
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSingleItemMap_WhenRemovingValueByKey_ThenMapBecomesEmpty,
                               K,
                               TestedKeyTypes)
@@ -591,6 +707,114 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMapsWithDifferentKeys_WhenComparingThem_Th
   BOOST_CHECK(map != other);
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenInsertingOrGettingKey_ThenItemIsInserted,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  auto result = map.insertOrGet(42);
+  result.first->second = "Alice";
+
+  BOOST_CHECK(result.second);
+  BOOST_CHECK_EQUAL(result.first->first, 42);
+  thenMapContainsItems(map, { { 42, "Alice" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenInsertingOrGettingExistingKey_ThenItemIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  auto result = map.insertOrGet(42);
+
+  BOOST_CHECK(!result.second);
+  BOOST_CHECK_EQUAL(result.first->second, "Alice");
+  BOOST_CHECK_EQUAL(map.getSize(), 2);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenClearing_ThenMapBecomesEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 753, "Rome" }, { 1410, "Grunwald" }, { 1789, "Paris" } };
+
+  map.clear();
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK_EQUAL(map.getSize(), 0);
+  BOOST_CHECK(map.find(753) == map.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenClearedMap_WhenAddingItem_ThenItemIsInMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+  map.clear();
+
+  map[13] = "Chuck";
+
+  thenMapContainsItems(map, { { 13, "Chuck" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenReadingStats_ThenTreeHasNoLevels,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  const aisdi::TreeStats stats = map.stats();
+
+  BOOST_CHECK_EQUAL(stats.size, 0);
+  BOOST_CHECK_EQUAL(stats.height, 0);
+  BOOST_CHECK(stats.depthHistogram.empty());
+  BOOST_CHECK(stats.balanceFactors.empty());
+  BOOST_CHECK_EQUAL(stats.nodeBytes, 0);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenBranchingTree_WhenReadingStats_ThenShapeIsReported,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = { { 50, "e" }, { 20, "b" }, { 80, "h" }, { 10, "a" }, { 30, "c" },
+                       { 40, "d" }, { 70, "g" }, { 60, "f" }, { 90, "i" } };
+
+  const aisdi::TreeStats stats = map.stats();
+
+  BOOST_CHECK_EQUAL(stats.height, 4);
+  BOOST_CHECK_EQUAL(stats.minimalHeight(), 4);
+  BOOST_CHECK_EQUAL(stats.maxDepth, 3);
+  BOOST_CHECK_CLOSE(stats.averageDepth, 16.0 / 9, 1e-9);
+  const std::vector<std::size_t> depths = { 1, 2, 4, 2 };
+  BOOST_CHECK(stats.depthHistogram == depths);
+  const std::map<long, std::size_t> balanceFactors = { { -1, 2 }, { 0, 5 }, { 1, 2 } };
+  BOOST_CHECK(stats.balanceFactors == balanceFactors);
+  BOOST_CHECK_EQUAL(stats.unbalancedNodes, 0);
+  BOOST_CHECK(stats.nodeBytes >= 9 * sizeof(std::pair<const K, std::string>));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSortedInsertions_WhenReadingStats_ThenTreeIsReportedAsList,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (K key = 0; key < 10; key++)
+    map[key] = "x";
+
+  const aisdi::TreeStats stats = map.stats();
+
+  BOOST_CHECK_EQUAL(stats.height, 10);
+  BOOST_CHECK_EQUAL(stats.minimalHeight(), 4);
+  BOOST_CHECK_CLOSE(stats.averageDepth, 4.5, 1e-9);
+  const std::map<long, std::size_t> balanceFactors = { { 0, 1 }, { 1, 1 }, { 2, 1 }, { 3, 1 },
+                                                       { 4, 1 }, { 5, 1 }, { 6, 1 }, { 7, 1 },
+                                                       { 8, 1 }, { 9, 1 } };
+  BOOST_CHECK(stats.balanceFactors == balanceFactors);
+  BOOST_CHECK_EQUAL(stats.unbalancedNodes, 8);
+}
+
 // ConstIterator is tested via Iterator methods.
 // If Iterator methods are to be changed, then new ConstIterator tests are required.
 